@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    Multi-voice chorus: NumVoices modulated taps read from one delay line.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CircularBuffer.h"
+#include "LFO.h"
+#include "ControlRate.h"
+
+/** NumVoices taps from the same delay line, each with its own LFO lane; the voice count is a
+    template parameter so every width gets its own fixed-trip-count kernel across the voice lanes.
+    SampleType is the delay line's lane type; the LFOs stay float either way */
+template <int NumVoices, typename SampleType = float>
+class ChorusVoices
+{
+public:
+	static_assert(NumVoices == 2 || NumVoices == 4 || NumVoices == 8, "ChorusVoices supports 2, 4 or 8 voices");
+
+	ChorusVoices() {}		/* C-TOR */
+	~ChorusVoices() {}		/* D-TOR */
+
+	/** do NOT call from realtime audio thread; do this, and useScratch(), prior to any processing */
+	void prepare(double sampleRate)
+	{
+		samplesPerMs = (float)(sampleRate / 1000.0);
+
+		// --- spread the voices evenly around the cycle so they never line up
+		for (int voice = 0; voice < NumVoices; ++voice)
+			lfos.setPhaseOffset(voice, (float)voice / (float)NumVoices);
+
+		lfos.prepare(sampleRate);
+		lfos.reset();
+		appliedRate = appliedDepth = -1.0f;		// --- depth in samples depends on the sample rate
+
+		for (auto& state : tapStates)
+			state = {};
+	}
+
+	/** work in NumVoices rows of maximumBlockSize floats owned by the caller (the processor's arena); they
+	//	   are written and read back within each process() call, so voice sets that never process at the
+	//	   same time can share them. do NOT call from realtime audio thread */
+	void useScratch(float* const* rows, int maximumBlockSize)
+	{
+		modulation.setDataToReferTo(const_cast<float**>(rows), NumVoices, maximumBlockSize);
+	}
+
+	/** set the shared rate (Hz) and depth (ms); each voice's rate is detuned slightly around the shared one */
+	void setParameters(float rateInHz, float depthInMs)
+	{
+		// --- the increments only need recomputing when something moved
+		if (rateInHz == appliedRate && depthInMs == appliedDepth)
+			return;
+
+		appliedRate = rateInHz;
+		appliedDepth = depthInMs;
+
+		for (int voice = 0; voice < NumVoices; ++voice)
+		{
+			const float spread = 2.0f * (float)voice / (float)(NumVoices - 1) - 1.0f;
+
+			lfos.setRate(voice, rateInHz * (1.0f + rateSpread * spread));
+			lfos.setDepth(voice, depthInMs * samplesPerMs);		// --- LFO output directly in samples
+		}
+	}
+
+	/** evaluate the voice LFOs every interval samples (see ControlRate) */
+	void setControlInterval(int interval)
+	{
+		jassert(ControlRate::isValidInterval(interval));
+		controlInterval = interval;
+	}
+
+	/** mix the voices around baseDelaySamples into output, reading one lane of the delay line; call straight
+	//	   after writing the block to the delay line, like CircularBuffer::readBlockFractional() */
+	template <typename Interpolator, typename Element>
+	void process(const CircularBuffer<Element>& delayLine, int lane, const float* baseDelaySamples, SampleType* output, int numSamples)
+	{
+		static_assert(std::is_same<typename CircularBuffer<Element>::SampleType, SampleType>::value, "delay line of another precision");
+
+		jassert(numSamples <= modulation.getNumSamples());
+
+		for (int voice = 0; voice < NumVoices; ++voice)
+			ControlRate::render(modulation.getWritePointer(voice), numSamples, controlInterval,
+								[this, voice] (int t) { return lfos.getValue(voice, t); });
+
+		lfos.skip(numSamples);
+		const float* const* voiceModulation = modulation.getArrayOfReadPointers();
+
+		for (int i = 0; i < numSamples; ++i)
+		{
+			alignas(32) float delays[NumVoices];
+			alignas(32) SampleType taps[NumVoices];
+
+			for (int voice = 0; voice < NumVoices; ++voice)
+				delays[voice] = juce::jmax((float)Interpolator::newerTaps, baseDelaySamples[i] + voiceModulation[voice][i]);
+
+			// --- the block is already written, so read back from where sample i was
+			delayLine.template readLaneTaps<NumVoices, Interpolator>(lane, delays, taps, numSamples - i, tapStates);
+
+			// --- mix across the voice lanes
+			SampleType sum = 0;
+
+			for (int voice = 0; voice < NumVoices; ++voice)
+				sum += taps[voice];
+
+			output[i] = sum * voiceGain;
+		}
+	}
+
+	/** move the voice LFOs on by numSamples without reading, as if a block had been processed */
+	void skip(int numSamples)
+	{
+		lfos.skip(numSamples);
+	}
+
+	/** true when both would read the same delay line back identically */
+	bool hasSameStateAs(const ChorusVoices& other) const
+	{
+		if (!lfos.hasSameStateAs(other.lfos))
+			return false;
+
+		for (int voice = 0; voice < NumVoices; ++voice)
+			if (tapStates[voice].lastOutput != other.tapStates[voice].lastOutput)
+				return false;
+
+		return true;
+	}
+
+	/** take over the other voices' read heads, for a channel that is shadowing another */
+	void copyReadStates(const ChorusVoices& other)
+	{
+		std::copy(std::begin(other.tapStates), std::end(other.tapStates), std::begin(tapStates));
+	}
+
+private:
+	static constexpr float rateSpread = 0.05f;						///< +/- 5% rate detune across the voices
+	static constexpr SampleType voiceGain = (SampleType)1 / (SampleType)NumVoices;
+
+	LFOBank<NumVoices> lfos;
+	juce::AudioBuffer<float> modulation;	///< per-voice LFO output in samples for the current block, not owned
+	InterpolatorState<SampleType> tapStates[NumVoices];		///< one read head per voice
+	float samplesPerMs = 44.1f;
+	float appliedRate = -1.0f;		///< what the LFOs were last set to
+	float appliedDepth = -1.0f;
+	int controlInterval = ControlRate::defaultInterval;
+};
+
+/** the 2, 4 and 8 voice kernels for one delay line, with a single per-block dispatch on the voice count */
+template <typename SampleType = float>
+class ChorusEnsemble
+{
+public:
+	/** do NOT call from realtime audio thread; do this, and useScratch(), prior to any processing */
+	void prepare(double sampleRate)
+	{
+		voices2.prepare(sampleRate);
+		voices4.prepare(sampleRate);
+		voices8.prepare(sampleRate);
+	}
+
+	/** scratchRowsNeeded rows of maximumBlockSize floats owned by the caller; only one voice count runs per
+	//	   block, so the three share them. do NOT call from realtime audio thread */
+	void useScratch(float* const* rows, int maximumBlockSize)
+	{
+		voices2.useScratch(rows, maximumBlockSize);
+		voices4.useScratch(rows, maximumBlockSize);
+		voices8.useScratch(rows, maximumBlockSize);
+	}
+
+	static constexpr int scratchRowsNeeded = 8;		///< one per voice of the widest set
+
+	/** evaluate the voice LFOs every interval samples (see ControlRate) */
+	void setControlInterval(int interval)
+	{
+		voices2.setControlInterval(interval);
+		voices4.setControlInterval(interval);
+		voices8.setControlInterval(interval);
+	}
+
+	/** numVoices must be 2, 4 or 8 */
+	template <typename Interpolator, typename Element>
+	void process(int numVoices, const CircularBuffer<Element>& delayLine, int lane, const float* baseDelaySamples,
+				 SampleType* output, int numSamples, float rateInHz, float depthInMs)
+	{
+		switch (numVoices)
+		{
+			case 2: run<Interpolator>(voices2, delayLine, lane, baseDelaySamples, output, numSamples, rateInHz, depthInMs); break;
+			case 4: run<Interpolator>(voices4, delayLine, lane, baseDelaySamples, output, numSamples, rateInHz, depthInMs); break;
+			case 8: run<Interpolator>(voices8, delayLine, lane, baseDelaySamples, output, numSamples, rateInHz, depthInMs); break;
+			default: jassertfalse; break;
+		}
+	}
+
+	/** keep the selected voices' LFOs in time across a block that was not processed */
+	void skip(int numVoices, int numSamples, float rateInHz, float depthInMs)
+	{
+		switch (numVoices)
+		{
+			case 2: voices2.setParameters(rateInHz, depthInMs); voices2.skip(numSamples); break;
+			case 4: voices4.setParameters(rateInHz, depthInMs); voices4.skip(numSamples); break;
+			case 8: voices8.setParameters(rateInHz, depthInMs); voices8.skip(numSamples); break;
+			default: jassertfalse; break;
+		}
+	}
+
+	bool hasSameStateAs(const ChorusEnsemble& other) const
+	{
+		return voices2.hasSameStateAs(other.voices2) && voices4.hasSameStateAs(other.voices4) && voices8.hasSameStateAs(other.voices8);
+	}
+
+	/** follow another ensemble that processed the same input over a block this one skipped */
+	void mirror(const ChorusEnsemble& other, int numVoices, int numSamples, float rateInHz, float depthInMs)
+	{
+		skip(numVoices, numSamples, rateInHz, depthInMs);
+
+		voices2.copyReadStates(other.voices2);
+		voices4.copyReadStates(other.voices4);
+		voices8.copyReadStates(other.voices8);
+	}
+
+private:
+	template <typename Interpolator, typename Voices, typename Element>
+	static void run(Voices& voices, const CircularBuffer<Element>& delayLine, int lane, const float* baseDelaySamples,
+					SampleType* output, int numSamples, float rateInHz, float depthInMs)
+	{
+		voices.setParameters(rateInHz, depthInMs);
+		voices.template process<Interpolator>(delayLine, lane, baseDelaySamples, output, numSamples);
+	}
+
+	ChorusVoices<2, SampleType> voices2;
+	ChorusVoices<4, SampleType> voices4;
+	ChorusVoices<8, SampleType> voices8;
+};
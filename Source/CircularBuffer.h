@@ -0,0 +1,589 @@
+/*
+  ==============================================================================
+
+    Power-of-two circular buffer used for the delay lines.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Interpolators.h"
+
+/** one time step of NumChannels channels stored side by side, so a delay line of frames serves every
+    channel with one write index and one cache line per step */
+template <int NumChannels, typename SampleType = float>
+struct alignas(sizeof(SampleType) * NumChannels) Frame
+{
+	static_assert(NumChannels > 0 && (NumChannels & (NumChannels - 1)) == 0, "Frame width must be a power of two");
+
+	SampleType samples[NumChannels];
+
+	Frame operator+(const Frame& other) const { Frame r; for (int c = 0; c < NumChannels; ++c) r.samples[c] = samples[c] + other.samples[c]; return r; }
+	Frame operator-(const Frame& other) const { Frame r; for (int c = 0; c < NumChannels; ++c) r.samples[c] = samples[c] - other.samples[c]; return r; }
+	Frame operator*(SampleType gain) const { Frame r; for (int c = 0; c < NumChannels; ++c) r.samples[c] = samples[c] * gain; return r; }
+};
+
+/** per-lane access to the element types a CircularBuffer can hold: plain samples (one lane),
+    Frame<N> and juce::dsp::SIMDRegister. SampleType is what one lane holds (float or double), and so
+    what the buffer's planar reads and writes take */
+template <typename T>
+struct FrameLanes
+{
+	using SampleType = T;
+	static constexpr int numLanes = 1;
+	static T get(const T& frame, int) { return frame; }
+	static void set(T& frame, int, T value) { frame = value; }
+};
+
+template <int NumChannels, typename Sample>
+struct FrameLanes<Frame<NumChannels, Sample>>
+{
+	using SampleType = Sample;
+	static constexpr int numLanes = NumChannels;
+	static Sample get(const Frame<NumChannels, Sample>& frame, int lane) { return frame.samples[lane]; }
+	static void set(Frame<NumChannels, Sample>& frame, int lane, Sample value) { frame.samples[lane] = value; }
+};
+
+template <typename ElementType>
+struct FrameLanes<juce::dsp::SIMDRegister<ElementType>>
+{
+	using SampleType = ElementType;
+	static constexpr int numLanes = (int)juce::dsp::SIMDRegister<ElementType>::SIMDNumElements;
+	static ElementType get(const juce::dsp::SIMDRegister<ElementType>& frame, int lane) { return frame.get((size_t)lane); }
+	static void set(juce::dsp::SIMDRegister<ElementType>& frame, int lane, ElementType value) { frame.set((size_t)lane, value); }
+};
+
+template <typename T>
+class CircularBuffer
+{
+public:
+	using SampleType = typename FrameLanes<T>::SampleType;		///< one lane of an element
+
+	CircularBuffer() {}		/* C-TOR */
+	~CircularBuffer() {}	/* D-TOR */
+
+							/** flush buffer by resetting all values to 0.0; only the part written since the last flush is
+	//	   cleared, the rest is known to hold zeros already */
+	void flushBuffer()
+	{
+		if (highWaterMark > 0)
+		{
+			memset(&data[0], 0, highWaterMark * sizeof(T));
+
+			// --- the guard is a copy of the top, so it can only hold something when the buffer does
+			memset(&data[bufferLength], 0, guardSamples * sizeof(T));
+		}
+
+		highWaterMark = 0;
+	}
+
+	/** true when the current storage is the double-mapped kind */
+	bool isMirrored() const { return mirrored; }
+
+	/** guard samples kept after a buffer of the given length when it isn't mirrored */
+	static unsigned int getGuardSamples(unsigned int bufferLengthPowerOfTwo) { return juce::jmin((unsigned int)defaultGuardSamples, bufferLengthPowerOfTwo); }
+
+	/** run on memory owned elsewhere (e.g. a DspArena) instead of allocating: lengthPowerOfTwo elements,
+	//	   followed by getGuardSamples() more unless the memory is mirrored. zeroed says the memory holds
+	//	   nothing but zeros; handed the same memory again, only what was written since is cleared.
+	//	   do NOT call from realtime audio thread */
+	void useStorage(T* storage, unsigned int lengthPowerOfTwo, bool mirroredStorage, bool zeroed)
+	{
+		jassert(storage != nullptr && lengthPowerOfTwo > 0 && (lengthPowerOfTwo & (lengthPowerOfTwo - 1)) == 0);
+
+		const bool sameStorage = storage == data && lengthPowerOfTwo == bufferLength && mirroredStorage == mirrored;
+
+		if (!sameStorage)
+		{
+			data = storage;
+			bufferLength = lengthPowerOfTwo;
+			wrapMask = bufferLength - 1;
+			mirrored = mirroredStorage;
+			guardSamples = mirrored ? 0 : getGuardSamples(bufferLength);
+			contiguousSamples = mirrored ? bufferLength : guardSamples;
+			highWaterMark = zeroed ? 0 : bufferLength;
+		}
+
+		writeIndex = 0;
+		readState = {};
+		flushBuffer();
+	}
+
+	/** let go of the memory, e.g. for a delay line the current bus layout does not use; call useStorage()
+	//	   again before using it. do NOT call from realtime audio thread */
+	void releaseBuffer()
+	{
+		mirrored = false;
+		data = nullptr;
+		writeIndex = bufferLength = wrapMask = guardSamples = contiguousSamples = highWaterMark = 0;
+		readState = {};
+	}
+
+	/** write a value into the buffer; this overwrites the previous oldest value in the buffer */
+	void writeBuffer(T input)
+	{
+		// --- write, keep the guard copy of the top of the buffer in sync, and increment index counter
+		data[writeIndex] = input;
+
+		if (writeIndex < guardSamples)
+			data[writeIndex + bufferLength] = input;
+
+		++writeIndex;
+		highWaterMark = juce::jmax(highWaterMark, writeIndex);
+
+		// --- wrap if index > bufferlength - 1
+		writeIndex &= wrapMask;
+	}
+
+	/** read an arbitrary location that is delayInSamples old */
+	T readBuffer(int delayInSamples)//, bool readBeforeWrite = true)
+	{
+		// --- subtract to make read index
+		//     note: -1 here is because we read-before-write,
+		//           so the *last* write location is what we use for the calculation
+		int readIndex = (writeIndex - 1) - delayInSamples;
+
+		// --- autowrap index
+		readIndex &= wrapMask;
+
+		// --- read it
+		return data[readIndex];
+	}
+
+	/** read an arbitrary location that includes a fractional sample */
+	T readBuffer(double delayInFractionalSamples)
+	{
+		// --- truncate delayInFractionalSamples and read the int part
+		T y1 = readBuffer((int)delayInFractionalSamples);
+
+		// --- if no interpolation, just return value
+		if (!interpolate) return y1;
+
+		// --- else do interpolation
+		//
+		// --- read the sample at n+1 (one sample OLDER)
+		T y2 = readBuffer((int)delayInFractionalSamples + 1);
+
+		// --- get fractional part, in the precision of the samples
+		const auto fraction = (SampleType)(delayInFractionalSamples - (int)delayInFractionalSamples);
+
+		// --- do the interpolation (you could try different types here)
+		return y1 + (y2 - y1) * fraction;
+	}
+
+	/** write a block of values into the buffer; the block is copied as at most two contiguous spans
+	//	   (up to the end of the buffer, then from the top) instead of masking every sample, or as one span
+	//	   when the memory is mirrored */
+	void writeBlock(const T* input, int numSamples)
+	{
+		jassert(numSamples >= 0 && (unsigned int)numSamples <= bufferLength);
+
+		if (isMirrored())
+		{
+			// --- the second mapping makes the wrap invisible
+			memcpy(&data[writeIndex], input, (size_t)numSamples * sizeof(T));
+		}
+		else
+		{
+			// --- first span runs up to the end of the buffer, the remainder wraps to the top
+			const unsigned int firstSpan = juce::jmin((unsigned int)numSamples, bufferLength - writeIndex);
+			const unsigned int secondSpan = (unsigned int)numSamples - firstSpan;
+
+			memcpy(&data[writeIndex], input, firstSpan * sizeof(T));
+			memcpy(&data[0], input + firstSpan, secondSpan * sizeof(T));
+
+			// --- refresh the guard copy if the top of the buffer was written
+			if (writeIndex < guardSamples || secondSpan > 0)
+				memcpy(&data[bufferLength], &data[0], guardSamples * sizeof(T));
+		}
+
+		markWritten((unsigned int)numSamples);
+		writeIndex = (writeIndex + (unsigned int)numSamples) & wrapMask;
+	}
+
+	/** read a block of fractional delays; call this straight after writeBlock() with the same block length.
+	//	   delaySamples[i] is relative to input sample i, exactly as readBuffer(double) sees it in a
+	//	   per-sample read-then-write loop, so both paths produce the same output. For frame element
+	//	   types every channel is read at the same delay. Block reads share one interpolator state, so
+	//	   use them for a single read head per buffer */
+	template <typename Interpolator = Interpolators::Linear>
+	void readBlockFractional(const float* delaySamples, T* output, int numSamples)
+	{
+		if constexpr (!std::is_same<Interpolator, Interpolators::None>::value)
+			if (!interpolate) return readBlockFractional<Interpolators::None>(delaySamples, output, numSamples);
+
+		// --- index of the last write *before* sample 0 of the block (read-before-write, as in readBuffer)
+		const int blockStart = (int)writeIndex - numSamples - 1;
+
+		for (int chunkStart = 0; chunkStart < numSamples; chunkStart += readChunkSize)
+		{
+			const int chunkLength = juce::jmin(readChunkSize, numSamples - chunkStart);
+			readChunk<Interpolator>(blockStart + chunkStart, delaySamples + chunkStart, output + chunkStart, chunkLength, readState);
+		}
+	}
+
+	/** write one block of planar channels into a buffer of frames, lane c taking channels[c];
+	//	   lanes past numChannels are left untouched */
+	void writeChannels(const SampleType* const* channels, int numChannels, int numSamples)
+	{
+		jassert(numChannels <= FrameLanes<T>::numLanes);
+		jassert(numSamples >= 0 && (unsigned int)numSamples <= bufferLength);
+
+		// --- same two spans as writeBlock, interleaving as we go
+		const int firstSpan = isMirrored() ? numSamples : juce::jmin(numSamples, (int)(bufferLength - writeIndex));
+
+		for (int c = 0; c < numChannels; ++c)
+		{
+			T* frames = &data[writeIndex];
+
+			for (int i = 0; i < firstSpan; ++i)
+				FrameLanes<T>::set(frames[i], c, channels[c][i]);
+
+			for (int i = firstSpan; i < numSamples; ++i)
+				FrameLanes<T>::set(data[i - firstSpan], c, channels[c][i]);
+		}
+
+		if (!isMirrored() && (writeIndex < guardSamples || firstSpan < numSamples))
+			memcpy(&data[bufferLength], &data[0], guardSamples * sizeof(T));
+
+		markWritten((unsigned int)numSamples);
+		writeIndex = (writeIndex + (unsigned int)numSamples) & wrapMask;
+	}
+
+	/** true when two lanes' read heads carry the same interpolator state, so the same history and delays
+	//	   read back the same samples */
+	bool readStatesMatch(int laneA, int laneB) const
+	{
+		return FrameLanes<T>::get(readState.lastOutput, laneA) == FrameLanes<T>::get(readState.lastOutput, laneB);
+	}
+
+	/** give destLane's read head sourceLane's interpolator state, for a lane that is being shadowed rather
+	//	   than read */
+	void mirrorReadState(int sourceLane, int destLane)
+	{
+		FrameLanes<T>::set(readState.lastOutput, destLane, FrameLanes<T>::get(readState.lastOutput, sourceLane));
+	}
+
+	/** read each lane of a buffer of frames at its own fractional delays into planar outputs; call straight
+	//	   after writeChannels() / writeBlock() with the same block length. When every lane asks for the same
+	//	   delays, one index computation per sample serves the whole frame */
+	template <typename Interpolator = Interpolators::Linear>
+	void readLanesFractional(const float* const* delaySamples, SampleType* const* outputs, int numLanes, int numSamples)
+	{
+		jassert(numLanes <= FrameLanes<T>::numLanes);
+
+		if constexpr (!std::is_same<Interpolator, Interpolators::None>::value)
+			if (!interpolate) return readLanesFractional<Interpolators::None>(delaySamples, outputs, numLanes, numSamples);
+
+		constexpr int olderTaps = Interpolator::olderTaps;
+		constexpr int numTaps = olderTaps + 1 + Interpolator::newerTaps;
+
+		bool sharedDelays = true;
+
+		for (int lane = 1; lane < numLanes && sharedDelays; ++lane)
+			sharedDelays = memcmp(delaySamples[lane], delaySamples[0], (size_t)numSamples * sizeof(float)) == 0;
+
+		if (sharedDelays)
+			return readLanesSharedDelay<Interpolator>(delaySamples[0], outputs, numLanes, numSamples);
+
+		const int blockStart = (int)writeIndex - numSamples - 1;
+
+		for (int chunkStart = 0; chunkStart < numSamples; chunkStart += readChunkSize)
+		{
+			const int chunkLength = juce::jmin(readChunkSize, numSamples - chunkStart);
+			const int base = blockStart + chunkStart;
+
+			for (int lane = 0; lane < numLanes; ++lane)
+			{
+				const float* delays = delaySamples[lane] + chunkStart;
+				SampleType* out = outputs[lane] + chunkStart;
+
+				alignas(32) SampleType taps[numTaps][readChunkSize];
+				alignas(32) float fraction[readChunkSize];
+
+				for (int i = 0; i < chunkLength; ++i)
+				{
+					const int intPart = (int)delays[i];
+
+					// --- one mask per sample; the neighbours are adjacent even across the wrap
+					const T* window = &data[(base + i - intPart - olderTaps) & (int)wrapMask];
+
+					fraction[i] = delays[i] - (float)intPart;
+
+					for (int tap = 0; tap < numTaps; ++tap)
+						taps[tap][i] = FrameLanes<T>::get(window[tap], lane);
+				}
+
+				// --- each lane keeps its own lane of the read state
+				InterpolatorState<SampleType> laneState { FrameLanes<T>::get(readState.lastOutput, lane) };
+				interpolateChunk<Interpolator>(taps, fraction, out, chunkLength, laneState);
+				FrameLanes<T>::set(readState.lastOutput, lane, laneState.lastOutput);
+			}
+		}
+	}
+
+	/** readLanesFractional() for callers that know every lane reads at the same delays: whole frames are
+	//	   read with one index computation per sample, then split into the lanes */
+	template <typename Interpolator = Interpolators::Linear>
+	void readLanesSharedDelay(const float* delaySamples, SampleType* const* outputs, int numLanes, int numSamples)
+	{
+		jassert(numLanes <= FrameLanes<T>::numLanes);
+
+		if constexpr (!std::is_same<Interpolator, Interpolators::None>::value)
+			if (!interpolate) return readLanesSharedDelay<Interpolators::None>(delaySamples, outputs, numLanes, numSamples);
+
+		const int blockStart = (int)writeIndex - numSamples - 1;
+
+		for (int chunkStart = 0; chunkStart < numSamples; chunkStart += readChunkSize)
+		{
+			const int chunkLength = juce::jmin(readChunkSize, numSamples - chunkStart);
+
+			alignas(32) T frames[readChunkSize];
+			readChunk<Interpolator>(blockStart + chunkStart, delaySamples + chunkStart, frames, chunkLength, readState);
+
+			for (int lane = 0; lane < numLanes; ++lane)
+				for (int i = 0; i < chunkLength; ++i)
+					outputs[lane][chunkStart + i] = FrameLanes<T>::get(frames[i], lane);
+		}
+	}
+
+	/** read each lane at one constant delay for the whole block (a settled, unmodulated delay line); call
+	//	   straight after writeChannels() / writeBlock() with the same block length. Each chunk's read window
+	//	   is one contiguous span, so a whole number of samples is a straight copy, and otherwise the
+	//	   interpolator runs over the span with a fixed fraction; the results match readLanesFractional() */
+	template <typename Interpolator = Interpolators::Linear>
+	void readLanesConstantDelay(const float* delaySamples, SampleType* const* outputs, int numLanes, int numSamples)
+	{
+		jassert(numLanes <= FrameLanes<T>::numLanes);
+
+		if constexpr (!std::is_same<Interpolator, Interpolators::None>::value)
+			if (!interpolate) return readLanesConstantDelay<Interpolators::None>(delaySamples, outputs, numLanes, numSamples);
+
+		constexpr int olderTaps = Interpolator::olderTaps;
+		constexpr int numTaps = olderTaps + 1 + Interpolator::newerTaps;
+		jassert(readChunkSize + numTaps - 1 <= (int)contiguousSamples);
+
+		const int blockStart = (int)writeIndex - numSamples - 1;
+
+		for (int lane = 0; lane < numLanes; ++lane)
+		{
+			jassert(delaySamples[lane] >= (float)Interpolator::newerTaps);
+
+			const int intPart = (int)delaySamples[lane];
+			const float fraction = delaySamples[lane] - (float)intPart;
+			SampleType* out = outputs[lane];
+
+			InterpolatorState<SampleType> laneState { FrameLanes<T>::get(readState.lastOutput, lane) };
+
+			for (int chunkStart = 0; chunkStart < numSamples; chunkStart += readChunkSize)
+			{
+				const int chunkLength = juce::jmin(readChunkSize, numSamples - chunkStart);
+
+				// --- one mask per chunk; the guard / mirror keeps the rest of the window contiguous
+				const T* window = &data[(blockStart + chunkStart - intPart - olderTaps) & (int)wrapMask];
+
+				if (fraction == 0.0f)
+				{
+					// --- every interpolator returns the sample itself at a zero fraction
+					for (int i = 0; i < chunkLength; ++i)
+						out[chunkStart + i] = FrameLanes<T>::get(window[i + olderTaps], lane);
+
+					laneState.lastOutput = out[chunkStart + chunkLength - 1];
+					continue;
+				}
+
+				// --- the taps for sample i are span[i .. i + numTaps - 1], so each tap array is the span shifted
+				alignas(32) SampleType span[readChunkSize + numTaps - 1];
+
+				for (int i = 0; i < chunkLength + numTaps - 1; ++i)
+					span[i] = FrameLanes<T>::get(window[i], lane);
+
+				const SampleType* tapArrays[numTaps];
+
+				for (int tap = 0; tap < numTaps; ++tap)
+					tapArrays[tap] = span + tap;
+
+				for (int i = 0; i < chunkLength; ++i)
+					out[chunkStart + i] = Interpolator::compute(tapArrays, i, fraction, laneState);
+			}
+
+			FrameLanes<T>::set(readState.lastOutput, lane, laneState.lastOutput);
+		}
+	}
+
+	/** read NumTaps fractional delays for one sample into a lane-aligned output; the base index is
+	//	   computed once, then all taps are gathered in one masked pass and interpolated across the lanes.
+	//	   samplesAgo moves the base back, e.g. (numSamples - i) for sample i of a block already written.
+	//	   states holds one interpolator state per tap and may be null for the stateless interpolators */
+	template <int NumTaps, typename Interpolator = Interpolators::Linear>
+	void readTaps(const float* delaySamples, T* output, int samplesAgo = 0, InterpolatorState<T>* states = nullptr) const
+	{
+		if constexpr (!std::is_same<Interpolator, Interpolators::None>::value)
+			if (!interpolate) return readTaps<NumTaps, Interpolators::None>(delaySamples, output, samplesAgo, states);
+
+		constexpr int olderTaps = Interpolator::olderTaps;
+		constexpr int numTaps = olderTaps + 1 + Interpolator::newerTaps;
+
+		// --- same read-before-write base as readBuffer, shared by every tap
+		const int base = (int)writeIndex - 1 - samplesAgo;
+
+		alignas(32) T taps[numTaps][NumTaps];
+		alignas(32) float fraction[NumTaps];
+
+		for (int tap = 0; tap < NumTaps; ++tap)
+		{
+			const int intPart = (int)delaySamples[tap];
+
+			// --- one mask per tap; the neighbours and the tap itself are adjacent even across the wrap
+			const T* window = &data[(base - intPart - olderTaps) & (int)wrapMask];
+
+			fraction[tap] = delaySamples[tap] - (float)intPart;
+
+			for (int k = 0; k < numTaps; ++k)
+				taps[k][tap] = window[k];
+		}
+
+		interpolateTaps<Interpolator>(taps, fraction, output, states);
+	}
+
+	/** readTaps() for a single lane of a buffer of frames, gathering only that lane */
+	template <int NumTaps, typename Interpolator = Interpolators::Linear>
+	void readLaneTaps(int lane, const float* delaySamples, SampleType* output, int samplesAgo = 0, InterpolatorState<SampleType>* states = nullptr) const
+	{
+		if constexpr (!std::is_same<Interpolator, Interpolators::None>::value)
+			if (!interpolate) return readLaneTaps<NumTaps, Interpolators::None>(lane, delaySamples, output, samplesAgo, states);
+
+		constexpr int olderTaps = Interpolator::olderTaps;
+		constexpr int numTaps = olderTaps + 1 + Interpolator::newerTaps;
+
+		const int base = (int)writeIndex - 1 - samplesAgo;
+
+		alignas(32) SampleType taps[numTaps][NumTaps];
+		alignas(32) float fraction[NumTaps];
+
+		for (int tap = 0; tap < NumTaps; ++tap)
+		{
+			const int intPart = (int)delaySamples[tap];
+			const T* window = &data[(base - intPart - olderTaps) & (int)wrapMask];
+
+			fraction[tap] = delaySamples[tap] - (float)intPart;
+
+			for (int k = 0; k < numTaps; ++k)
+				taps[k][tap] = FrameLanes<T>::get(window[k], lane);
+		}
+
+		interpolateTaps<Interpolator>(taps, fraction, output, states);
+	}
+
+	/** enable or disable interpolation; usually used for diagnostics or in algorithms that require strict integer samples times */
+	void setInterpolate(bool b) { interpolate = b; }
+
+  unsigned int getBufferLength() { return bufferLength; }
+
+private:
+	static constexpr int readChunkSize = 64;			///< samples gathered per pass in readBlockFractional
+	static constexpr int defaultGuardSamples = 2 * readChunkSize;	///< contiguous overrun when not mirrored
+
+	/** extend highWaterMark over numSamples about to be written from writeIndex; a write that wraps makes
+	//	   the whole buffer dirty */
+	void markWritten(unsigned int numSamples)
+	{
+		highWaterMark = juce::jmax(highWaterMark, juce::jmin(writeIndex + numSamples, bufferLength));
+	}
+
+	/** read up to readChunkSize fractional delays; base is the read-before-write index of the chunk's first sample */
+	template <typename Interpolator>
+	void readChunk(int base, const float* delays, T* output, int chunkLength, InterpolatorState<T>& state)
+	{
+		constexpr int olderTaps = Interpolator::olderTaps;
+		constexpr int newerTaps = Interpolator::newerTaps;
+
+		alignas(32) T taps[olderTaps + 1 + newerTaps][readChunkSize];
+		alignas(32) float fraction[readChunkSize];
+
+		// --- the delays in a chunk only span a few samples, so the whole read window fits in the
+		//     mirrored / guard region and can be read as one plain pointer range without masking
+		const auto delayRange = juce::FloatVectorOperations::findMinAndMax(delays, chunkLength);
+		jassert(delayRange.getStart() >= (float)newerTaps);		// --- newer taps must already be written
+
+		const int oldest = base - (int)delayRange.getEnd() - olderTaps;
+		const int windowLength = chunkLength + (int)delayRange.getEnd() - (int)delayRange.getStart() + olderTaps + newerTaps;
+
+		if (windowLength <= (int)contiguousSamples)
+			gatherTaps<Interpolator, false>(&data[oldest & (int)wrapMask], base - oldest, delays, taps, fraction, chunkLength);
+		else
+			gatherTaps<Interpolator, true>(data, base, delays, taps, fraction, chunkLength);
+
+		interpolateChunk<Interpolator>(taps, fraction, output, chunkLength, state);
+	}
+
+	/** gather every tap the interpolator needs and the fractional part for each sample of a chunk, one
+	    array per tap; base is the read-before-write index of the chunk's first sample relative to source */
+	template <typename Interpolator, bool wrap>
+	void gatherTaps(const T* source, int base, const float* delays, T (*taps)[readChunkSize], float* fraction, int numSamples) const
+	{
+		constexpr int olderTaps = Interpolator::olderTaps;
+		constexpr int numTaps = olderTaps + 1 + Interpolator::newerTaps;
+
+		for (int i = 0; i < numSamples; ++i)
+		{
+			const int intPart = (int)delays[i];
+			const int readIndex = base + i - intPart;
+
+			// --- when wrapping, mask once and rely on the guard / mirror for the neighbours
+			const T* window = wrap ? &source[(readIndex - olderTaps) & (int)wrapMask] : &source[readIndex - olderTaps];
+
+			fraction[i] = delays[i] - (float)intPart;
+
+			for (int tap = 0; tap < numTaps; ++tap)
+				taps[tap][i] = window[tap];
+		}
+	}
+
+	/** run the interpolator along a chunk of gathered taps; the stateless ones are straight-line loops over
+	    the tap arrays, so they vectorise across the chunk */
+	template <typename Interpolator, typename Element, int Capacity>
+	static void interpolateChunk(Element (*taps)[Capacity], const float* fraction, Element* output, int numSamples, InterpolatorState<Element>& state)
+	{
+		constexpr int numTaps = Interpolator::olderTaps + 1 + Interpolator::newerTaps;
+
+		const Element* tapArrays[numTaps];
+
+		for (int tap = 0; tap < numTaps; ++tap)
+			tapArrays[tap] = taps[tap];
+
+		for (int i = 0; i < numSamples; ++i)
+			output[i] = Interpolator::compute(tapArrays, i, fraction[i], state);
+	}
+
+	/** run the interpolator across the taps of one sample, each tap with its own state if given */
+	template <typename Interpolator, typename Element, int NumTaps>
+	static void interpolateTaps(Element (*taps)[NumTaps], const float* fraction, Element* output, InterpolatorState<Element>* states)
+	{
+		constexpr int numTaps = Interpolator::olderTaps + 1 + Interpolator::newerTaps;
+
+		const Element* tapArrays[numTaps];
+
+		for (int k = 0; k < numTaps; ++k)
+			tapArrays[k] = taps[k];
+
+		InterpolatorState<Element> scratch;
+
+		for (int tap = 0; tap < NumTaps; ++tap)
+			output[tap] = Interpolator::compute(tapArrays, tap, fraction[tap], states != nullptr ? states[tap] : scratch);
+	}
+
+	T* data = nullptr;						///< storage owned elsewhere (the processor's arena), see useStorage()
+	unsigned int guardSamples = 0;			///< samples past the end kept equal to the top (0 when mirrored)
+	unsigned int contiguousSamples = 0;		///< samples readable past any index without wrapping
+	bool mirrored = false;					///< data is mapped twice back to back
+	unsigned int highWaterMark = 0;			///< elements from data[0] that may be non-zero (plus the guard, which
+											///< mirrors them); everything past it is zero, so flushBuffer() stops here
+	unsigned int writeIndex = 0;		///> write index
+	unsigned int bufferLength = 1024;	///< must be nearest power of 2
+	unsigned int wrapMask = bufferLength - 1;		///< must be (bufferLength - 1)
+	bool interpolate = true;			///< interpolation (default is ON)
+	InterpolatorState<T> readState;		///< carried between block reads, for the recursive interpolators
+};
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    Control-rate evaluation of slowly moving values, interpolated to audio rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** delay times, LFOs and smoothers move far below 100 Hz, so they only need evaluating every few samples;
+	a straight line between control points is inaudible and costs one multiply-add per sample */
+struct ControlRate
+{
+	static constexpr int defaultInterval = 16;
+	static constexpr int maxInterval = 32;
+
+	/** true for the supported intervals: powers of two up to maxInterval (8, 16 or 32 in normal use,
+		1 evaluates every sample) */
+	static bool isValidInterval(int interval)
+	{
+		return interval > 0 && interval <= maxInterval && juce::isPowerOfTwo(interval);
+	}
+
+	/** fill output with numSamples values by evaluating valueAt(t) at t = 0, interval, 2 * interval ...
+		and numSamples, and joining them with straight lines; valueAt(t) is the value for sample t of the
+		block (t == numSamples being the first sample of the next one) and must not move any state on.
+		breakpoint marks a sample where the slope changes (e.g. where a ramp ends); the segment holding it
+		is split there so the corner is kept rather than cut */
+	template <typename ValueAt>
+	static void render(float* output, int numSamples, int interval, ValueAt&& valueAt, int breakpoint = -1)
+	{
+		jassert(isValidInterval(interval));
+
+		float previous = valueAt(0);
+		int start = 0;
+
+		while (start < numSamples)
+		{
+			int length = juce::jmin(interval, numSamples - start);
+
+			if (breakpoint > start && breakpoint < start + length)
+				length = breakpoint - start;
+
+			const float next = valueAt(start + length);
+			const float slope = (next - previous) / (float)length;
+
+			for (int i = 0; i < length; ++i)
+				output[start + i] = previous + slope * (float)i;
+
+			previous = next;
+			start += length;
+		}
+	}
+};
@@ -0,0 +1,338 @@
+/*
+  ==============================================================================
+
+    One contiguous block per plugin instance for the buffers the audio thread
+    streams through.
+
+  ==============================================================================
+*/
+
+#include "DspArena.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    inline size_t alignUp (size_t value, size_t alignment) noexcept   { return (value + alignment - 1) / alignment * alignment; }
+
+    // the PMD size of x86-64 and of arm64 with 4 KiB pages
+    constexpr size_t hugePageSize = 2 * 1024 * 1024;
+}
+
+size_t DspArena::getPageSize()
+{
+   #if JUCE_LINUX || JUCE_MAC
+    return (size_t) sysconf (_SC_PAGESIZE);
+   #else
+    return 4096;
+   #endif
+}
+
+bool DspArena::canHold (const std::vector<Region>& regions) const
+{
+    if (base == nullptr || regions.size() != layout.size() || ! (options == allocatedOptions))
+        return false;
+
+    for (size_t i = 0; i < regions.size(); ++i)
+        if (regions[i].mirrored ? ! (regions[i] == layout[i])
+                                : (layout[i].mirrored || regions[i].numBytes > layout[i].numBytes))
+            return false;
+
+    return true;
+}
+
+bool DspArena::allocate (const std::vector<Region>& regions)
+{
+    release();
+
+    layout = regions;
+    offsets.assign (layout.size(), 0);
+    allocatedOptions = options;
+
+    if (! (options.hugePages && allocateHugePages()) && ! allocateMirrored()
+         && ! (options.lockPages && allocatePages()))
+        allocateHeap();
+
+    if (base != nullptr && options.lockPages && ! layout.empty())
+        prefaultAndLock();
+
+    return base != nullptr;
+}
+
+bool DspArena::allocateMirrored()
+{
+   #if JUCE_LINUX && defined (MFD_CLOEXEC)
+    const auto pageSize = getPageSize();
+
+    for (const auto& region : layout)
+        if (region.mirrored && (region.numBytes == 0 || region.numBytes % pageSize != 0))
+            return false;
+
+    // one file holds every region once; the address range holds the mirrored ones twice. Runs of plain
+    // regions are mapped as one piece, and each mirrored region starts on a page in both
+    struct Mapping { size_t address, fileOffset, length; };
+    std::vector<Mapping> mappings;
+
+    size_t fileCursor = 0, addressCursor = 0;
+    size_t runFileStart = 0, runAddressStart = 0;
+
+    auto closeRun = [&]
+    {
+        const size_t end = alignUp (fileCursor, pageSize);
+        addressCursor += end - fileCursor;
+        fileCursor = end;
+
+        if (fileCursor > runFileStart)
+            mappings.push_back ({ runAddressStart, runFileStart, fileCursor - runFileStart });
+    };
+
+    for (size_t i = 0; i < layout.size(); ++i)
+    {
+        const auto& region = layout[i];
+
+        if (region.mirrored)
+        {
+            closeRun();
+
+            offsets[i] = addressCursor;
+            mappings.push_back ({ addressCursor,                   fileCursor, region.numBytes });
+            mappings.push_back ({ addressCursor + region.numBytes, fileCursor, region.numBytes });
+
+            addressCursor += 2 * region.numBytes;
+            fileCursor += region.numBytes;
+
+            runFileStart = fileCursor;
+            runAddressStart = addressCursor;
+        }
+        else
+        {
+            const size_t start = alignUp (fileCursor, alignment);
+            offsets[i] = addressCursor + (start - fileCursor);
+            addressCursor = offsets[i] + region.numBytes;
+            fileCursor = start + region.numBytes;
+        }
+    }
+
+    closeRun();
+
+    if (fileCursor == 0)
+        return false;
+
+    const int fd = memfd_create ("chorus-dsp-arena", MFD_CLOEXEC);
+
+    if (fd < 0)
+        return false;
+
+    if (ftruncate (fd, (off_t) fileCursor) != 0)
+    {
+        close (fd);
+        return false;
+    }
+
+    // reserve the whole range first so nothing else can land in between
+    auto* reserved = static_cast<char*> (mmap (nullptr, addressCursor, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+    if (reserved == MAP_FAILED)
+    {
+        close (fd);
+        return false;
+    }
+
+    bool mapped = true;
+
+    for (const auto& mapping : mappings)
+        mapped = mapped && mmap (reserved + mapping.address, mapping.length, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_FIXED, fd, (off_t) mapping.fileOffset) != MAP_FAILED;
+
+    // the mappings keep the pages alive
+    close (fd);
+
+    if (! mapped)
+    {
+        munmap (reserved, addressCursor);
+        return false;
+    }
+
+    base = reserved;
+    numBytes = fileCursor;
+    mapping = reserved;
+    mappedBytes = addressCursor;
+    mirrored = true;
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool DspArena::allocateHugePages()
+{
+   #if JUCE_LINUX && defined (MADV_HUGEPAGE)
+    const auto size = layOutContiguously();
+
+    // below one huge page there is nothing to gain, and mirroring is worth more
+    if (size < hugePageSize)
+        return false;
+
+    // anonymous memory, over-allocated by one huge page so the arena can start on a boundary
+    const auto length = alignUp (size, hugePageSize) + hugePageSize;
+    auto* mapped = static_cast<char*> (mmap (nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+    if (mapped == MAP_FAILED)
+        return false;
+
+    base = mapped + (hugePageSize - (size_t) reinterpret_cast<juce::pointer_sized_uint> (mapped) % hugePageSize) % hugePageSize;
+
+    // only advice: with THP disabled the pages are just small
+    madvise (base, alignUp (size, hugePageSize), MADV_HUGEPAGE);
+
+    numBytes = size;
+    mapping = mapped;
+    mappedBytes = length;
+    mirrored = false;
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool DspArena::allocatePages()
+{
+   #if JUCE_LINUX || JUCE_MAC
+    // locked memory has to own its pages: a heap block can share its first and last page with another
+    // instance's, and munlock on one would then unlock them under the other
+    const auto size = layOutContiguously();
+    const auto length = alignUp (size, getPageSize());
+    auto* mapped = static_cast<char*> (mmap (nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+    if (mapped == MAP_FAILED)
+        return false;
+
+    base = mapped;
+    numBytes = size;
+    mapping = mapped;
+    mappedBytes = length;
+    mirrored = false;
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+size_t DspArena::layOutContiguously()
+{
+    size_t cursor = 0;
+
+    for (size_t i = 0; i < layout.size(); ++i)
+    {
+        offsets[i] = alignUp (cursor, alignment);
+        cursor = offsets[i] + layout[i].numBytes + (layout[i].mirrored ? layout[i].guardBytes : 0);
+    }
+
+    return alignUp (cursor, alignment);
+}
+
+void DspArena::allocateHeap()
+{
+    numBytes = layOutContiguously();
+
+    // calloc, so large arenas come straight from zeroed pages; over-allocated by one line to align the start
+    heap.calloc (numBytes + alignment);
+    base = heap.get() + (alignment - (size_t) reinterpret_cast<juce::pointer_sized_uint> (heap.get()) % alignment) % alignment;
+    mirrored = false;
+}
+
+size_t DspArena::getRegionEnd (size_t index) const
+{
+    const auto& region = layout[index];
+
+    if (! region.mirrored)
+        return offsets[index] + region.numBytes;
+
+    return offsets[index] + (mirrored ? 2 * region.numBytes : region.numBytes + region.guardBytes);
+}
+
+void DspArena::prefaultAndLock()
+{
+    const auto end = getRegionEnd (layout.size() - 1);
+    const auto pageSize = getPageSize();
+
+    // the memory is still all zeros, so writing a zero into every page changes nothing but gets the page
+    // backed now (a read would only map the shared zero page). Both views of a mirrored region are touched,
+    // each has its own page table entries
+    auto* const bytes = static_cast<volatile char*> (base);
+
+    for (size_t offset = 0; offset < end; offset += pageSize)
+        bytes[offset] = 0;
+
+    bytes[end - 1] = 0;
+
+   #if JUCE_LINUX || JUCE_MAC
+    // mlock works in whole pages, and that is what counts against RLIMIT_MEMLOCK: the ranges run from the
+    // page holding base (a heap arena needn't start on one) to the end of the page an offset falls in
+    auto* const lockStart = getLockStart();
+    auto pagesUpTo = [this, lockStart, pageSize] (size_t offset) { return alignUp ((size_t) (base + offset - lockStart), pageSize); };
+
+    // all of it at once, or else as much of the front as RLIMIT_MEMLOCK allows: the hot state and the
+    // scratch first, then the delay lines one by one
+    if (mlock (lockStart, pagesUpTo (end)) == 0)
+    {
+        lockedBytes = pagesUpTo (end);
+        return;
+    }
+
+    for (size_t i = 0; i < layout.size(); ++i)
+    {
+        const auto regionEnd = pagesUpTo (getRegionEnd (i));
+
+        if (regionEnd > lockedBytes && mlock (lockStart + lockedBytes, regionEnd - lockedBytes) != 0)
+            break;
+
+        lockedBytes = juce::jmax (lockedBytes, regionEnd);
+    }
+   #endif
+}
+
+char* DspArena::getLockStart() const
+{
+    const auto address = reinterpret_cast<juce::pointer_sized_uint> (base);
+    return base - address % getPageSize();
+}
+
+void DspArena::release()
+{
+   #if JUCE_LINUX || JUCE_MAC
+    // unmapping unlocks by itself; a heap block (locked only when mapping pages failed) goes back to the
+    // allocator unlocked
+    if (lockedBytes > 0 && mapping == nullptr)
+        munlock (getLockStart(), lockedBytes);
+
+    if (mapping != nullptr)
+        munmap (mapping, mappedBytes);
+   #endif
+
+    heap.free();
+    base = nullptr;
+    numBytes = mappedBytes = lockedBytes = 0;
+    mapping = nullptr;
+    mirrored = false;
+    layout.clear();
+    offsets.clear();
+}
+
+void DspArena::swap (DspArena& other) noexcept
+{
+    std::swap (layout, other.layout);
+    std::swap (offsets, other.offsets);
+    std::swap (base, other.base);
+    std::swap (numBytes, other.numBytes);
+    std::swap (options, other.options);
+    std::swap (allocatedOptions, other.allocatedOptions);
+    std::swap (mapping, other.mapping);
+    std::swap (mappedBytes, other.mappedBytes);
+    std::swap (heap, other.heap);
+    std::swap (mirrored, other.mirrored);
+    std::swap (lockedBytes, other.lockedBytes);
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    One contiguous block per plugin instance for the buffers the audio thread
+    streams through.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/** Regions laid out front to back in the order they are given, each starting on a cache line, so one
+	instance's working set is a single range the prefetchers can follow. Regions asked for as mirrored (the
+	delay lines) are mapped twice back to back where the platform allows it (data[i + size] aliases data[i],
+	so a read window never wraps), and the arena is still one virtual range; elsewhere the whole arena is
+	one heap block and those regions get their guard bytes after them instead.
+
+	Options can have the pages faulted in and locked when the arena is allocated (hosts rendering under
+	memory pressure otherwise page the delay lines out between blocks) and ask for transparent huge pages */
+class DspArena
+{
+public:
+	static constexpr size_t alignment = 64;		///< a cache line, and the widest vector load
+
+	struct Region
+	{
+		size_t numBytes = 0;
+		size_t guardBytes = 0;		///< after a mirrored region when it can't be mirrored
+		bool mirrored = false;
+
+		bool operator==(const Region& other) const { return numBytes == other.numBytes && guardBytes == other.guardBytes && mirrored == other.mirrored; }
+	};
+
+	/** how the memory is provided; all off by default */
+	struct Options
+	{
+		bool lockPages = false;		///< fault every page in up front and mlock it, so the audio thread never
+									///< waits on a page fault or on swap
+		bool hugePages = false;		///< transparent huge pages for arenas of at least one (gives up mirroring)
+
+		bool operator==(const Options& other) const { return lockPages == other.lockPages && hugePages == other.hugePages; }
+	};
+
+	DspArena() {}						/* C-TOR */
+	~DspArena() { release(); }			/* D-TOR */
+
+	/** for the next allocate() */
+	void setOptions(const Options& newOptions) { options = newOptions; }
+	const Options& getOptions() const { return options; }
+
+	/** true when the memory already has room for these regions: the same mirrored ones, and plain ones no
+		bigger than they were allocated (a smaller block size keeps the scratch it had), allocated with the
+		current options */
+	bool canHold(const std::vector<Region>& regions) const;
+
+	/** allocate zero-filled memory for the regions, giving up whatever was there before; false on failure.
+	//	   do NOT call from realtime audio thread */
+	bool allocate(const std::vector<Region>& regions);
+
+	/** give the memory back */
+	void release();
+
+	/** start of a region, in the order given to allocate() */
+	template <typename T>
+	T* getRegion(int index) const { return reinterpret_cast<T*>(base + offsets[(size_t)index]); }
+
+	/** whether the mirrored regions really are; if not, they have their guard bytes */
+	bool isMirrored() const { return mirrored; }
+
+	/** bytes of memory behind the arena (the second view of a mirrored region costs none) */
+	size_t getNumBytes() const { return numBytes; }
+
+	/** bytes of the arena's address range locked into RAM, in whole pages and with both views of a mirrored
+		region counted (that is what counts against RLIMIT_MEMLOCK); less than the whole range when the limit
+		is too low, in which case the front of the arena is locked first. 0 unless Options::lockPages */
+	size_t getNumLockedBytes() const { return lockedBytes; }
+
+	void swap(DspArena& other) noexcept;
+
+private:
+	/** lay the regions out for mirroring; false if one of them can't be (not a whole number of pages) */
+	bool allocateMirrored();
+	bool allocateHugePages();
+	/** whole pages of their own for a locked arena that isn't mirrored */
+	bool allocatePages();
+	void allocateHeap();
+
+	/** offsets for one plain block, guard bytes after the mirrored regions; returns the size */
+	size_t layOutContiguously();
+
+	/** end of region index in the address range, relative to base */
+	size_t getRegionEnd(size_t index) const;
+
+	void prefaultAndLock();
+
+	/** the page base lies in, where locking starts */
+	char* getLockStart() const;
+
+	static size_t getPageSize();
+
+	std::vector<Region> layout;
+	std::vector<size_t> offsets;		///< of each region from base
+
+	Options options, allocatedOptions;
+
+	char* base = nullptr;
+	size_t numBytes = 0;
+	void* mapping = nullptr;			///< the mirrored, huge-page or locked mapping, nullptr for the heap kind
+	size_t mappedBytes = 0;
+	juce::HeapBlock<char> heap;
+	bool mirrored = false;
+	size_t lockedBytes = 0;				///< whole pages from getLockStart()
+
+	JUCE_DECLARE_NON_COPYABLE(DspArena)
+};
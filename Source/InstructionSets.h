@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    Instruction-set variants of the DSP kernels, picked at runtime.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if (JUCE_GCC || JUCE_CLANG) && JUCE_INTEL
+ #include <cpuid.h>
+#endif
+
+/** the kernels are compiled once per instruction set from the same source: each variant is a policy whose
+	run() is built for its target and flattened, so everything the kernel calls is inlined into that one
+	function and generated for the target with it. No other symbol is compiled for the wider set, so
+	nothing built for AVX2 can end up shared with, and called from, the baseline variant.
+
+	GCC and Clang on x86 only; elsewhere (MSVC, ARM) the baseline is the only variant */
+#if (JUCE_GCC || JUCE_CLANG) && JUCE_INTEL
+ #define CHORUS_MULTIPLE_INSTRUCTION_SETS 1
+#else
+ #define CHORUS_MULTIPLE_INSTRUCTION_SETS 0
+#endif
+
+/** the variants, in ascending order */
+enum class InstructionSet
+{
+	baseline,	///< whatever the build targets: SSE2 on x86-64, NEON on arm64
+	avx2,		///< 256-bit AVX2 with FMA
+	avx512		///< AVX-512 F / VL / BW / DQ
+};
+
+namespace InstructionSets
+{
+	struct Baseline
+	{
+		template <typename Function>
+		static void run(Function&& function) { function(); }
+	};
+
+   #if CHORUS_MULTIPLE_INSTRUCTION_SETS
+	struct Avx2
+	{
+		template <typename Function>
+		__attribute__((target("avx2,fma"), flatten)) static void run(Function&& function) { function(); }
+	};
+
+	struct Avx512
+	{
+		template <typename Function>
+		__attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma"), flatten)) static void run(Function&& function) { function(); }
+	};
+   #endif
+
+   #if CHORUS_MULTIPLE_INSTRUCTION_SETS
+	/** the register state the OS saves on a context switch (XCR0), 0 when it doesn't manage it through
+	//	   XSAVE; the CPUID feature bits alone don't say whether the YMM/ZMM registers survive a switch */
+	inline juce::uint64 getOsSavedRegisterState()
+	{
+		unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+		if (! __get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_OSXSAVE) == 0)
+			return 0;
+
+		unsigned int low = 0, high = 0;
+		__asm__ volatile ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));	// no target("xsave") needed
+		return ((juce::uint64) high << 32) | low;
+	}
+
+	static constexpr juce::uint64 ymmState = 0x6;		///< SSE and AVX state
+	static constexpr juce::uint64 zmmState = 0xe6;		///< plus opmask and both ZMM halves
+   #endif
+
+	/** the widest variant this CPU (and OS) can run */
+	inline InstructionSet getBest()
+	{
+	   #if CHORUS_MULTIPLE_INSTRUCTION_SETS
+		const auto osState = getOsSavedRegisterState();
+
+		if ((osState & zmmState) == zmmState
+			&& juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL()
+			&& juce::SystemStats::hasAVX512BW() && juce::SystemStats::hasAVX512DQ())
+			return InstructionSet::avx512;
+
+		if ((osState & ymmState) == ymmState
+			&& juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+			return InstructionSet::avx2;
+	   #endif
+
+		return InstructionSet::baseline;
+	}
+}
+
+/** call function with a default-constructed policy object for the given set, e.g.
+	dispatchInstructionSet(set, [&](auto target) { decltype(target)::run([&] { kernel(...); }); });
+	one switch per block, like dispatchInterpolator() */
+template <typename Function>
+void dispatchInstructionSet(InstructionSet set, Function&& function)
+{
+	switch (set)
+	{
+	   #if CHORUS_MULTIPLE_INSTRUCTION_SETS
+		case InstructionSet::avx512:	function(InstructionSets::Avx512 {}); break;
+		case InstructionSet::avx2:		function(InstructionSets::Avx2 {}); break;
+	   #endif
+		case InstructionSet::baseline:	function(InstructionSets::Baseline {}); break;
+		default:						jassertfalse; break;
+	}
+}
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    Fractional-delay interpolators used as compile-time policies by CircularBuffer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** read state carried between samples by a read head; only the allpass uses it */
+template <typename T>
+struct InterpolatorState
+{
+	T lastOutput {};
+};
+
+/** Each policy reads olderTaps samples older and newerTaps samples newer than the integer read position
+	and blends them by the fractional part (0 to 1, towards the older sample).
+
+	compute() gets one array per tap, oldest first (the integer position is taps[olderTaps]), and the index
+	of the sample to produce. Block reads hand it struct-of-arrays chunks so the stateless policies run as
+	straight float loops the compiler can vectorise; single reads point each array at the sample itself.
+	Newer taps look ahead of the integer position, so delays must be at least newerTaps samples. */
+namespace Interpolators
+{
+	/** truncate; no interpolation */
+	struct None
+	{
+		static constexpr int olderTaps = 0;
+		static constexpr int newerTaps = 0;
+
+		template <typename T>
+		static T compute(const T* const* taps, int i, float, InterpolatorState<T>&)
+		{
+			return taps[0][i];
+		}
+	};
+
+	/** straight line between the two neighbouring samples */
+	struct Linear
+	{
+		static constexpr int olderTaps = 1;
+		static constexpr int newerTaps = 0;
+
+		template <typename T>
+		static T compute(const T* const* taps, int i, float fraction, InterpolatorState<T>&)
+		{
+			const T older = taps[0][i];
+			const T current = taps[1][i];
+
+			return current + (older - current) * fraction;
+		}
+	};
+
+	/** 3rd-order Lagrange polynomial through four samples */
+	struct Lagrange
+	{
+		static constexpr int olderTaps = 2;
+		static constexpr int newerTaps = 1;
+
+		template <typename T>
+		static T compute(const T* const* taps, int i, float fraction, InterpolatorState<T>&)
+		{
+			const T older2 = taps[0][i];
+			const T older = taps[1][i];
+			const T current = taps[2][i];
+			const T newer = taps[3][i];
+
+			// --- basis polynomials for nodes at -1, 0, 1, 2
+			const float fp1 = fraction + 1.0f;
+			const float fm1 = fraction - 1.0f;
+			const float fm2 = fraction - 2.0f;
+
+			const float cNewer = -fraction * fm1 * fm2 * (1.0f / 6.0f);
+			const float cCurrent = fp1 * fm1 * fm2 * 0.5f;
+			const float cOlder = -fp1 * fraction * fm2 * 0.5f;
+			const float cOlder2 = fp1 * fraction * fm1 * (1.0f / 6.0f);
+
+			return newer * cNewer + current * cCurrent + older * cOlder + older2 * cOlder2;
+		}
+	};
+
+	/** 4-point, 3rd-order Hermite (Catmull-Rom) spline */
+	struct Hermite
+	{
+		static constexpr int olderTaps = 2;
+		static constexpr int newerTaps = 1;
+
+		template <typename T>
+		static T compute(const T* const* taps, int i, float fraction, InterpolatorState<T>&)
+		{
+			const T older2 = taps[0][i];
+			const T older = taps[1][i];
+			const T current = taps[2][i];
+			const T newer = taps[3][i];
+
+			const T c1 = (older - newer) * 0.5f;
+			const T c2 = newer - current * 2.5f + older * 2.0f - older2 * 0.5f;
+			const T c3 = (older2 - newer) * 0.5f + (current - older) * 1.5f;
+
+			return ((c3 * fraction + c2) * fraction + c1) * fraction + current;
+		}
+	};
+
+	/** first-order allpass (Thiran); flat magnitude response, but recursive, so it runs sample by sample.
+		The fractional delay is kept in [0.5, 1.5) by stepping one sample newer when below 0.5, which keeps
+		the pole away from -1 */
+	struct Allpass
+	{
+		static constexpr int olderTaps = 1;
+		static constexpr int newerTaps = 1;
+
+		template <typename T>
+		static T compute(const T* const* taps, int i, float fraction, InterpolatorState<T>& state)
+		{
+			const T older = taps[0][i];
+			const T current = taps[1][i];
+			const T newer = taps[2][i];
+
+			const bool stepNewer = fraction < 0.5f;
+			const float delta = stepNewer ? fraction + 1.0f : fraction;
+			const float eta = (1.0f - delta) / (1.0f + delta);
+
+			const T input = stepNewer ? newer : current;
+			const T previousInput = stepNewer ? current : older;
+
+			state.lastOutput = input * eta + previousInput - state.lastOutput * eta;
+			return state.lastOutput;
+		}
+	};
+}
+
+/** the interpolators selectable at runtime, in parameter order */
+enum class InterpolationType
+{
+	none,
+	linear,
+	lagrange,
+	hermite,
+	allpass
+};
+
+/** call function with a default-constructed policy object for the given type, e.g.
+	dispatchInterpolator(type, [&](auto policy) { read<decltype(policy)>(...); }); one switch per block
+	selects a fully specialised kernel */
+template <typename Function>
+void dispatchInterpolator(InterpolationType type, Function&& function)
+{
+	switch (type)
+	{
+		case InterpolationType::none:		function(Interpolators::None {}); break;
+		case InterpolationType::linear:		function(Interpolators::Linear {}); break;
+		case InterpolationType::lagrange:	function(Interpolators::Lagrange {}); break;
+		case InterpolationType::hermite:	function(Interpolators::Hermite {}); break;
+		case InterpolationType::allpass:	function(Interpolators::Allpass {}); break;
+		default:							jassertfalse; break;
+	}
+}
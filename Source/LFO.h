@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    Wavetable LFO driven by an integer phase accumulator.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** one cycle of a sine read through a 32-bit phase where 2^32 == one cycle; the top bits index the
+    table and the rest is the interpolation fraction. A single harmonic, so band-limited at any rate */
+struct SineWavetable
+{
+	static constexpr int tableBits = 11;								///< 2048 points per cycle
+	static constexpr int tableSize = 1 << tableBits;
+	static constexpr int fractionBits = 32 - tableBits;
+	static constexpr juce::uint32 fractionMask = (1u << fractionBits) - 1;
+	static constexpr float fractionScale = 1.0f / (float)(1u << fractionBits);
+	static constexpr double phaseRange = 4294967296.0;					///< 2^32, one full cycle
+
+	/** the table plus a guard point so index + 1 never needs wrapping; built on first use */
+	static const float* getTable()
+	{
+		struct Table
+		{
+			Table()
+			{
+				for (int i = 0; i <= tableSize; ++i)
+					values[(size_t)i] = (float)std::sin(juce::MathConstants<double>::twoPi * i / tableSize);
+			}
+
+			std::array<float, tableSize + 1> values;
+		};
+
+		static const Table table;
+		return table.values.data();
+	}
+
+	/** linearly interpolated lookup at a 32-bit phase */
+	static float lookup(const float* table, juce::uint32 phase)
+	{
+		const juce::uint32 index = phase >> fractionBits;
+		const float fraction = (float)(phase & fractionMask) * fractionScale;
+
+		const float y1 = table[index];
+		const float y2 = table[index + 1];
+
+		return y1 + fraction * (y2 - y1);
+	}
+
+	/** convert a rate in Hz to a per-sample phase increment */
+	static juce::uint32 getIncrement(float rateInHz, double sampleRate)
+	{
+		return (juce::uint32)((double)rateInHz / sampleRate * phaseRange);
+	}
+};
+
+/** a bank of sine LFOs stored as struct-of-arrays (phase, increment and depth per lane), so one
+    step advances every lane together; lanes are channels or voices */
+template <int NumLanes>
+class LFOBank
+{
+public:
+	LFOBank() {}		/* C-TOR */
+	~LFOBank() {}		/* D-TOR */
+
+	/** set the sample rate and build the shared table; do NOT call from realtime audio thread */
+	void prepare(double _sampleRate)
+	{
+		sampleRate = _sampleRate;
+		SineWavetable::getTable();
+
+		for (int lane = 0; lane < NumLanes; ++lane)
+			setRate(lane, rate[(size_t)lane]);
+	}
+
+	/** restart every lane at its own normalised phase offset (0 to 1) */
+	void reset()
+	{
+		for (int lane = 0; lane < NumLanes; ++lane)
+			phase[(size_t)lane] = phaseOffset[(size_t)lane];
+	}
+
+	/** set a lane's rate in Hz */
+	void setRate(int lane, float rateInHz)
+	{
+		rate[(size_t)lane] = rateInHz;
+		increment[(size_t)lane] = SineWavetable::getIncrement(rateInHz, sampleRate);
+	}
+
+	/** set a lane's depth; the output is depth * sin(phase) */
+	void setDepth(int lane, float newDepth) { depth[(size_t)lane] = newDepth; }
+
+	/** set a lane's phase offset (0 to 1) from the start of the cycle; applied on reset() */
+	void setPhaseOffset(int lane, float offset)
+	{
+		phaseOffset[(size_t)lane] = (juce::uint32)((double)offset * SineWavetable::phaseRange);
+	}
+
+	/** set every lane to the same rate and depth */
+	void setAll(float rateInHz, float newDepth)
+	{
+		for (int lane = 0; lane < NumLanes; ++lane)
+		{
+			setRate(lane, rateInHz);
+			setDepth(lane, newDepth);
+		}
+	}
+
+	/** a lane's output samplesAhead samples on, without moving on; control-rate callers evaluate the
+	//	   points they need and then skip() the block */
+	float getValue(int lane, int samplesAhead) const
+	{
+		const juce::uint32 lanePhase = phase[(size_t)lane] + increment[(size_t)lane] * (juce::uint32)samplesAhead;
+		return depth[(size_t)lane] * SineWavetable::lookup(SineWavetable::getTable(), lanePhase);
+	}
+
+	/** true when both lanes will produce the same output from here on */
+	bool lanesMatch(int laneA, int laneB) const
+	{
+		return phase[(size_t)laneA] == phase[(size_t)laneB] && increment[(size_t)laneA] == increment[(size_t)laneB]
+			&& depth[(size_t)laneA] == depth[(size_t)laneB];
+	}
+
+	/** true when every lane matches the other bank's */
+	bool hasSameStateAs(const LFOBank& other) const
+	{
+		return phase == other.phase && increment == other.increment && depth == other.depth;
+	}
+
+	/** move every lane on by numSamples without rendering */
+	void skip(int numSamples)
+	{
+		for (int lane = 0; lane < NumLanes; ++lane)
+			phase[(size_t)lane] += increment[(size_t)lane] * (juce::uint32)numSamples;
+	}
+
+private:
+	alignas(16) std::array<juce::uint32, NumLanes> phase {};			///< 2^32 == one cycle
+	alignas(16) std::array<juce::uint32, NumLanes> increment {};
+	alignas(16) std::array<float, NumLanes> depth {};
+	std::array<juce::uint32, NumLanes> phaseOffset {};
+	std::array<float, NumLanes> rate {};
+
+	double sampleRate = 44100.0;
+};
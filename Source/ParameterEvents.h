@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    Timestamped parameter changes, applied at their sample position in the block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+
+/** a parameter's raw value from sampleOffset (relative to the start of the block it is collected into) on */
+struct ParameterEvent
+{
+	int sampleOffset = 0;
+	ParameterSnapshot::Parameter parameter = ParameterSnapshot::delayLeft;
+	float value = 0.0f;
+};
+
+/** single-producer / single-consumer queue of parameter events. The producer is whatever can see the
+	host's timestamped changes (e.g. a format layer's per-block change list); the audio thread collects
+	everything pending at the start of each block, in time order. No locks or allocation on either side.
+
+	This is an extension point: JUCE's plugin wrappers hand parameter changes over as plain values with no
+	sample offset, so nothing in the plugin itself pushes here. Until a producer is connected (a custom
+	format layer, e.g. on VST3's IParameterChanges; Tools/ParameterEventTest is one for testing) the queue
+	stays empty and every change is picked up at the start of the block */
+class ParameterEventQueue
+{
+public:
+	static constexpr int capacity = 512;		///< events the queue holds, and the most one block collects
+
+	ParameterEventQueue() : fifo (capacity + 1) {}		/* C-TOR */
+
+	/** post an event for the next block; returns false (and drops it) if the queue is full */
+	bool push(const ParameterEvent& event)
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+		if (size1 + size2 == 0)
+			return false;
+
+		events[(size_t)(size1 > 0 ? start1 : start2)] = event;
+		fifo.finishedWrite(1);
+		return true;
+	}
+
+	/** take every pending event, clamped into [0, numSamples) and stably sorted by offset, into
+	//	   destination; returns how many were written (at most maxEvents, the rest stay queued) */
+	int collect(ParameterEvent* destination, int maxEvents, int numSamples)
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToRead(juce::jmin(maxEvents, fifo.getNumReady()), start1, size1, start2, size2);
+
+		int numEvents = 0;
+
+		for (int i = 0; i < size1; ++i)
+			destination[numEvents++] = events[(size_t)(start1 + i)];
+
+		for (int i = 0; i < size2; ++i)
+			destination[numEvents++] = events[(size_t)(start2 + i)];
+
+		fifo.finishedRead(numEvents);
+
+		// --- insertion sort: a handful of events, usually already in order
+		for (int i = 0; i < numEvents; ++i)
+		{
+			auto event = destination[i];
+			event.sampleOffset = juce::jlimit(0, juce::jmax(0, numSamples - 1), event.sampleOffset);
+
+			int j = i;
+
+			for (; j > 0 && destination[j - 1].sampleOffset > event.sampleOffset; --j)
+				destination[j] = destination[j - 1];
+
+			destination[j] = event;
+		}
+
+		return numEvents;
+	}
+
+	/** drop anything pending; do NOT call while the producer or audio thread is running */
+	void clear() { fifo.reset(); }
+
+private:
+	juce::AbstractFifo fifo;
+	std::array<ParameterEvent, capacity + 1> events;		///< AbstractFifo keeps one slot free
+
+	JUCE_DECLARE_NON_COPYABLE(ParameterEventQueue)
+};
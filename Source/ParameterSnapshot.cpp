@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    Per-block snapshot of the plugin parameters for the audio thread.
+
+  ==============================================================================
+*/
+
+#include "ParameterSnapshot.h"
+
+const char* const ParameterSnapshot::parameterIDs[numParameters] =
+{
+    "Delay Left",
+    "Delay Right",
+    "Depth",
+    "Rate",
+    "Dual Delay",
+    "Chorus",
+    "Voices",
+    "Interpolation"
+};
+
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+{
+    float rawValues[ParameterSnapshot::numParameters];
+
+    for (int i = 0; i < ParameterSnapshot::numParameters; ++i)
+        rawValues[i] = apvts.getRawParameterValue(ParameterSnapshot::parameterIDs[i])->load();
+
+    return ParameterSnapshot::toChainSettings(rawValues);
+}
+
+ParameterSnapshot::ParameterSnapshot (juce::AudioProcessorValueTreeState& apvts)
+{
+    for (int i = 0; i < numParameters; ++i)
+    {
+        handles[(size_t) i] = apvts.getRawParameterValue(parameterIDs[i]);
+        jassert(handles[(size_t) i] != nullptr);
+    }
+}
+
+ParameterSnapshot::DirtyMask ParameterSnapshot::update (DirtyMask deferred)
+{
+    DirtyMask dirty = 0;
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        if (loaded && (deferred & bit((Parameter) i)) != 0)
+            continue;
+
+        const float value = handles[(size_t) i]->load(std::memory_order_relaxed);
+
+        if (! loaded || value != rawValues[(size_t) i])
+        {
+            rawValues[(size_t) i] = value;
+            dirty |= bit((Parameter) i);
+        }
+    }
+
+    loaded = true;
+
+    if (dirty != 0)
+        settings = toChainSettings(rawValues.data());
+
+    return dirty;
+}
+
+ParameterSnapshot::DirtyMask ParameterSnapshot::apply (Parameter parameter, float rawValue)
+{
+    if (rawValues[(size_t) parameter] == rawValue)
+        return 0;
+
+    rawValues[(size_t) parameter] = rawValue;
+    settings = toChainSettings(rawValues.data());
+
+    return bit(parameter);
+}
+
+ChainSettings ParameterSnapshot::toChainSettings(const float* rawValues)
+{
+    ChainSettings settings;
+
+    settings.delayTimeLeft = rawValues[delayLeft];
+    settings.delayTimeRight = rawValues[delayRight];
+    settings.depth = rawValues[depth];
+    settings.rate = rawValues[rate];
+    settings.dualDelay = rawValues[dualDelay] < 0.5f;
+    settings.chorus = rawValues[chorus] < 0.5f;
+    settings.voices = 1 << (int) rawValues[voices]; // choice index 0..3 -> 1, 2, 4, 8 voices
+    settings.interpolation = (InterpolationType) (int) rawValues[interpolation];
+
+    return settings;
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    Per-block snapshot of the plugin parameters for the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Interpolators.h"
+
+struct ChainSettings {
+	float delayTimeLeft {0};
+	float delayTimeRight {0};
+	float depth {0};
+	float rate {0};
+	bool dualDelay {true};
+	bool chorus {false};
+	int voices {1};
+	InterpolationType interpolation {InterpolationType::linear};
+};
+
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+
+/** the parameters read on the audio thread. The std::atomic<float>* handles are looked up once at
+	construction, so a block costs one load per parameter and no string lookups; update() also reports
+	which parameters moved since the last block so derived state can be left alone when nothing did */
+class ParameterSnapshot
+{
+public:
+	enum Parameter
+	{
+		delayLeft,
+		delayRight,
+		depth,
+		rate,
+		dualDelay,
+		chorus,
+		voices,
+		interpolation,
+		numParameters
+	};
+
+	using DirtyMask = juce::uint32;
+
+	/** the dirty-mask bit for a parameter */
+	static constexpr DirtyMask bit(Parameter parameter) { return 1u << parameter; }
+
+	/** the parameter IDs, in Parameter order */
+	static const char* const parameterIDs[numParameters];
+
+	/** every parameter in parameterIDs must already exist in apvts; do NOT call from realtime audio thread */
+	explicit ParameterSnapshot(juce::AudioProcessorValueTreeState& apvts);
+
+	/** load every parameter once, at the start of each block; returns the mask of parameters whose value
+		differs from the previous update (all of them on the first). Parameters in deferred are left at
+		their previous value because timestamped events for this block will set them (see apply()) */
+	DirtyMask update(DirtyMask deferred = 0);
+
+	/** set one parameter's raw value mid-block; returns its bit if the value changed, else 0 */
+	DirtyMask apply(Parameter parameter, float rawValue);
+
+	/** the settings as of the last update() */
+	const ChainSettings& getSettings() const { return settings; }
+
+	/** convert raw parameter values, in Parameter order, to settings */
+	static ChainSettings toChainSettings(const float* rawValues);
+
+private:
+	std::array<std::atomic<float>*, numParameters> handles {};
+	std::array<float, numParameters> rawValues {};
+	ChainSettings settings;
+	bool loaded = false;
+
+	JUCE_DECLARE_NON_COPYABLE(ParameterSnapshot)
+};
@@ -187,7 +187,12 @@ ChorusAudioProcessorEditor::ChorusAudioProcessorEditor (ChorusAudioProcessor& p)
     rateSliderAttachment(audioProcessor.apvts, "Rate", rateSlider),
 
     dualDelayButtonAttachment(audioProcessor.apvts, "Dual Delay", dualDelayButton),
-    chorusButtonAttachment(audioProcessor.apvts, "Chorus", chorusButton)
+    chorusButtonAttachment(audioProcessor.apvts, "Chorus", chorusButton),
+
+    voicesBox(*audioProcessor.apvts.getParameter("Voices")),
+    interpolationBox(*audioProcessor.apvts.getParameter("Interpolation")),
+    voicesBoxAttachment(audioProcessor.apvts, "Voices", voicesBox),
+    interpolationBoxAttachment(audioProcessor.apvts, "Interpolation", interpolationBox)
 {
 
     delayTimeSliderLeft.setTextValueSuffix(" (ms)");
@@ -247,6 +252,8 @@ void ChorusAudioProcessorEditor::paint (juce::Graphics& g)
     juce::Rectangle<int> rateBounds = rateSlider.getBounds();
     juce::Rectangle<int> delayToggleButtonBounds = dualDelayButton.getBounds();
     juce::Rectangle<int> chorusToggleButtonBounds = chorusButton.getBounds();
+    juce::Rectangle<int> voicesBoxBounds = voicesBox.getBounds();
+    juce::Rectangle<int> interpolationBoxBounds = interpolationBox.getBounds();
 
     // g.setColour(juce::Colours::red);
     // g.drawRect(delayToggleButtonBounds); // just used for drawing bbox rects for ui layout
@@ -259,6 +266,8 @@ void ChorusAudioProcessorEditor::paint (juce::Graphics& g)
     rateBounds.setY(rateBounds.getBottom() + windowHeight * JUCE_LIVE_CONSTANT(-0.145f));
     delayToggleButtonBounds.setY(delayToggleButtonBounds.getY() + windowHeight * JUCE_LIVE_CONSTANT(-0.1f));
     chorusToggleButtonBounds.setY(chorusToggleButtonBounds.getY() + windowHeight * JUCE_LIVE_CONSTANT(0.1f));
+    voicesBoxBounds.setY(voicesBoxBounds.getY() - voicesBoxBounds.getHeight());
+    interpolationBoxBounds.setY(interpolationBoxBounds.getY() - interpolationBoxBounds.getHeight());
 
     g.drawFittedText("Delay Time Left", delayTimeSliderLeftBounds, juce::Justification::centred, 1);
     g.drawFittedText("Delay Time Right", delayTimeSliderRightBounds, juce::Justification::centred, 1);
@@ -266,6 +275,8 @@ void ChorusAudioProcessorEditor::paint (juce::Graphics& g)
     g.drawFittedText("Rate", rateBounds, juce::Justification::centred, 1);
     g.drawFittedText("Single / Dual", delayToggleButtonBounds, juce::Justification::centred, 1);
     g.drawFittedText("Chorus", chorusToggleButtonBounds, juce::Justification::centred, 1);
+    g.drawFittedText("Voices", voicesBoxBounds, juce::Justification::centred, 1);
+    g.drawFittedText("Interpolation", interpolationBoxBounds, juce::Justification::centred, 1);
 }
 
 void ChorusAudioProcessorEditor::resized()
@@ -289,6 +300,15 @@ void ChorusAudioProcessorEditor::resized()
     delayToggleArea.setY(delayToggleArea.getY() + windowHeight * JUCE_LIVE_CONSTANT(0.1f));
     chorusToggleArea.setY(chorusToggleArea.getY() + windowHeight * JUCE_LIVE_CONSTANT(0.5f));
 
+    // the chorus settings sit in the middle column, between the two toggles, each under its label
+    auto voicesArea = toggleArea;
+    voicesArea.setWidth(windowWidth * JUCE_LIVE_CONSTANT(0.2f));
+    voicesArea.setX(getLocalBounds().getCentreX() - voicesArea.getWidth() * 0.5f);
+    voicesArea.setHeight(windowHeight * JUCE_LIVE_CONSTANT(0.06f));
+    auto interpolationArea = voicesArea;
+    voicesArea.setY(voicesArea.getY() + windowHeight * JUCE_LIVE_CONSTANT(0.34f));
+    interpolationArea.setY(interpolationArea.getY() + windowHeight * JUCE_LIVE_CONSTANT(0.46f));
+
     delayTimeSliderLeft.setBounds(delayArea.removeFromLeft(delayArea.getWidth() * JUCE_LIVE_CONSTANT(0.33f)));
     delayTimeSliderRight.setBounds(delayArea.removeFromRight(delayArea.getWidth() * JUCE_LIVE_CONSTANT(0.5f)));
     depthSlider.setBounds(depthArea.removeFromLeft(depthArea.getWidth() * JUCE_LIVE_CONSTANT(0.4f)));
@@ -296,6 +316,8 @@ void ChorusAudioProcessorEditor::resized()
 
     dualDelayButton.setBounds(delayToggleArea.removeFromRight(delayToggleArea.getWidth() * JUCE_LIVE_CONSTANT(1.f)));
     chorusButton.setBounds(chorusToggleArea.removeFromRight(chorusToggleArea.getWidth() * JUCE_LIVE_CONSTANT(1.f)));
+    voicesBox.setBounds(voicesArea);
+    interpolationBox.setBounds(interpolationArea);
 
     int width = getWidth();
     int height = getHeight();
@@ -314,6 +336,8 @@ std::vector<juce::Component*> ChorusAudioProcessorEditor::getComps()
     &depthSlider,
     &rateSlider,
     &dualDelayButton,
-    &chorusButton
+    &chorusButton,
+    &voicesBox,
+    &interpolationBox
   };
 }
\ No newline at end of file
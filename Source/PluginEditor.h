@@ -70,6 +70,18 @@ private:
 
 struct EnableButton : juce::ToggleButton {};
 
+// a combo box listing a choice parameter's choices, in order, so a ComboBoxAttachment can drive it
+struct ChoiceComboBox : juce::ComboBox
+{
+  ChoiceComboBox(juce::RangedAudioParameter& rap)
+  {
+    if(auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(&rap))
+      addItemList(choiceParam->choices, 1);
+    else
+      jassertfalse;
+  }
+};
+
 //==============================================================================
 /**
 */
@@ -110,6 +122,10 @@ private:
     EnableButton dualDelayButton, chorusButton;
     ButtonAttachment dualDelayButtonAttachment, chorusButtonAttachment;
 
+    using ComboBoxAttachment = APVTS::ComboBoxAttachment;
+    ChoiceComboBox voicesBox, interpolationBox;
+    ComboBoxAttachment voicesBoxAttachment, interpolationBoxAttachment;
+
     std::vector<juce::Component*> getComps();
 
     //juce::Image background; // just used for drawing bbox rects for ui layout
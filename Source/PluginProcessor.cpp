@@ -30,6 +30,9 @@ ChorusAudioProcessor::ChorusAudioProcessor()
 
 ChorusAudioProcessor::~ChorusAudioProcessor()
 {
+    if (state != nullptr)
+        state->~HotState();
+
     // juce::File Log("**/build/Delay_artefacts/Debug/Standalone/feedback.txt"); // log making
     // juce::FileLogger Logger(feedbackLog, "Log Message");
     // Logger.logMessage("Value: " + juce::String(delayTimeLeft));
@@ -70,7 +73,8 @@ bool ChorusAudioProcessor::isMidiEffect() const
 
 double ChorusAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // the longest delay the controls allow, plus the furthest the modulation can push it
+    return ((double) maxDelayTimeMs + (double) maxDepthMs) / 1000.0;
 }
 
 int ChorusAudioProcessor::getNumPrograms()
@@ -100,25 +104,200 @@ void ChorusAudioProcessor::changeProgramName (int index, const juce::String& new
 //==============================================================================
 void ChorusAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    const juce::dsp::ProcessSpec spec{sampleRate, static_cast<juce::uint32>(samplesPerBlock), 2};
+    // state is only allocated for the channels the bus layout has: a mono bus gets one delay line and one
+    // filter chain, nothing for a right channel
+    numPreparedChannels = juce::jlimit(1, maxChannels, getTotalNumOutputChannels());
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    const juce::dsp::ProcessSpec spec{sampleRate, static_cast<juce::uint32>(samplesPerBlock), 2};
 
     currentSampleRate = getSampleRate();
 
-    coeff = 1.0f - std::exp( -1.0f / (0.1f * currentSampleRate)); // tape delay effect : one-pole filter
-    coeff_chrs = 1.0f - std::exp( -1.0f / (0.01f * currentSampleRate));
+    // the widest kernel variant the CPU runs, unless a narrower one was asked for
+    const auto bestInstructionSet = InstructionSets::getBest();
+    jassert(! instructionSetOverride.has_value() || *instructionSetOverride <= bestInstructionSet);
+    instructionSet = juce::jmin(instructionSetOverride.value_or(bestInstructionSet), bestInstructionSet);
+
+    // surround / ambisonic buses: channels side by side in groups of four, one SSE-wide frame per step
+    ambisonicLayout = getBusesLayout().getMainOutputChannelSet().getAmbisonicOrder() > 0;
+    numChannelGroups = numPreparedChannels > 2 ? (numPreparedChannels + 3) / 4 : 0;
+
+    // wide layouts can process their channel groups side by side, within the host's thread budget
+    const int threadBudget = hostWorkgroup ? (int) hostWorkgroup.getMaxParallelThreadCount() : 0;
+    const int numThreads = juce::jmin(numChannelGroups, threadBudget > 0 ? threadBudget : juce::SystemStats::getNumCpus());
+
+    workerPool.start(useWorkerThreads ? juce::jmax(0, numThreads - 1) : 0, hostWorkgroup);
+    parallelism.reset();
+
+    maxScratchSamples = juce::jmax(samplesPerBlock, 1);
+
+    // the furthest back any read can reach, including the oldest interpolator tap
+    drainSamples = (int) std::ceil(getTailLengthSeconds() * currentSampleRate) + Interpolators::Lagrange::olderTaps + 1;
+
+    // the host picks the precision before preparing; only that signal path holds any memory. This lays
+    // out the arena, so the hot state is there from here on
+    if (isUsingDoublePrecision())
+    {
+        floatPath.release();
+        bypassed = ! prepareSignalPath(doublePath, spec);
+    }
+    else
+    {
+        doublePath.release();
+        bypassed = ! prepareSignalPath(floatPath, spec);
+    }
+
+    // out of memory: better dry audio than none, until a later prepare gets its arena
+    if (bypassed)
+        return;
+
+    state->samplesPerMs = (float) (currentSampleRate / 1000.0);
+
+    state->smoothedDelayTimeLeft.reset(currentSampleRate, 0.3f);
+    state->smoothedDelayTimeRight.reset(currentSampleRate, 0.3f);
+    state->smoothedChorusDepth.reset(currentSampleRate, 0.01);
+    state->smoothedChorusRate.reset(currentSampleRate, 0.01);
+
+    state->chorusLFO.prepare(currentSampleRate);
+    state->chorusLFO.reset();
+
+    state->runParallel = false;
+    state->silentSamples = 0;
+    state->idle = false;
+    state->identicalSamples = 0;
+    state->identicalChannels = false;
+}
+
+template <typename SampleType>
+bool ChorusAudioProcessor::prepareSignalPath(SignalPath<SampleType>& path, const juce::dsp::ProcessSpec& spec)
+{
+    path.filterChains.resize((size_t) numPreparedChannels);
+
+    for (auto& chain : path.filterChains)
+        chain.prepare(spec);
+
+    path.ensembles.resize((size_t) numPreparedChannels);
+
+    for (auto& ensemble : path.ensembles)
+    {
+        ensemble.prepare(currentSampleRate);
+        ensemble.setControlInterval(controlInterval);
+    }
+
+    // the ensembles' scratch is in the arena too
+    return prepareArena(path);
+}
+
+template <typename SampleType>
+bool ChorusAudioProcessor::prepareArena(SignalPath<SampleType>& path)
+{
+    // the block is written before it is read back, so a read reaches a whole scratch chunk plus the longest
+    // modulated delay into the past; nothing older is ever needed
+    const auto delayLineLength = (unsigned int) juce::nextPowerOfTwo(drainSamples + maxScratchSamples);
+
+    const size_t frameBytes = numPreparedChannels == 1 ? sizeof(SampleType)
+                            : numPreparedChannels == 2 ? sizeof(Frame<2, SampleType>)
+                                                       : sizeof(Frame<4, SampleType>);
+
+    const int numDelayLines = numChannelGroups > 0 ? numChannelGroups : 1;
+    const int numCurves = juce::jmin(numPreparedChannels, 2);
+    const int numDelayedRows = juce::jmin(numPreparedChannels, 4) * (1 + workerPool.getNumWorkers());
+    const int numModulationRows = numPreparedChannels * ChorusEnsemble<SampleType>::scratchRowsNeeded;
+
+    // every scratch row starts on a cache line of its own
+    auto rowStride = [this] (int samplesPerLine) { return (maxScratchSamples + samplesPerLine - 1) / samplesPerLine * samplesPerLine; };
+    const int curveStride = rowStride((int) (DspArena::alignment / sizeof(float)));
+    const int delayedStride = rowStride((int) (DspArena::alignment / sizeof(SampleType)));
+
+    // front to back: what every block touches first, then the delay lines, one region each
+    enum { hotRegion, curveRegion, delayedRegion, modulationRegion, firstDelayLineRegion };
+
+    std::vector<DspArena::Region> layout;
+    layout.push_back({ sizeof(HotState) });
+    layout.push_back({ (size_t) (numCurves * curveStride) * sizeof(float) });
+    layout.push_back({ (size_t) (numDelayedRows * delayedStride) * sizeof(SampleType) });
+    layout.push_back({ (size_t) (numModulationRows * curveStride) * sizeof(float) });
+
+    for (int line = 0; line < numDelayLines; ++line)
+        layout.push_back({ delayLineLength * frameBytes, CircularBuffer<SampleType>::getGuardSamples(delayLineLength) * frameBytes, true });
+
+    // hosts prepare again on every transport start, block size change and bounce: while the arena has room,
+    // the memory is kept and the delay lines only clear what they wrote. Otherwise the hot state moves to
+    // the new arena, so the smoothers and LFOs carry on from where they were
+    const bool freshArena = ! arena.canHold(layout);
+
+    if (freshArena)
+    {
+        DspArena next;
+        next.setOptions(arena.getOptions());
+
+        // nothing is moved before the new memory is there: on failure the old arena and state stay whole
+        if (! next.allocate(layout))
+            return false;
+
+        auto* nextState = new (next.template getRegion<void>(hotRegion)) HotState(state != nullptr ? *state : HotState());
+
+        if (state != nullptr)
+            state->~HotState();
+
+        state = nextState;
+        arena.swap(next);
+    }
+
+    float* curves[2] {};
+
+    for (int curve = 0; curve < numCurves; ++curve)
+        curves[curve] = arena.template getRegion<float>(curveRegion) + curve * curveStride;
+
+    delayInSamples.setDataToReferTo(curves, numCurves, maxScratchSamples);
+
+    std::vector<SampleType*> delayedRows((size_t) numDelayedRows);
+
+    for (int row = 0; row < numDelayedRows; ++row)
+        delayedRows[(size_t) row] = arena.template getRegion<SampleType>(delayedRegion) + row * delayedStride;
+
+    path.delayedSamples.setDataToReferTo(delayedRows.data(), numDelayedRows, maxScratchSamples);
+
+    // one set of voice rows per channel, since channel groups can run on different workers
+    std::vector<float*> modulationRows((size_t) numModulationRows);
+
+    for (int row = 0; row < numModulationRows; ++row)
+        modulationRows[(size_t) row] = arena.template getRegion<float>(modulationRegion) + row * curveStride;
+
+    for (size_t channel = 0; channel < path.ensembles.size(); ++channel)
+        path.ensembles[channel].useScratch(modulationRows.data() + channel * ChorusEnsemble<SampleType>::scratchRowsNeeded, maxScratchSamples);
+
+    // the delay lines this layout doesn't use let go of their memory
+    const bool mirrored = arena.isMirrored();
+
+    if (numPreparedChannels == 1)
+        path.monoDelayLine.useStorage(arena.template getRegion<SampleType>(firstDelayLineRegion), delayLineLength, mirrored, freshArena);
+    else
+        path.monoDelayLine.releaseBuffer();
+
+    if (numPreparedChannels == 2)
+        path.delayLine.useStorage(arena.template getRegion<Frame<2, SampleType>>(firstDelayLineRegion), delayLineLength, mirrored, freshArena);
+    else
+        path.delayLine.releaseBuffer();
+
+    if (numPreparedChannels <= 2)
+    {
+        path.groupDelayLines.reset();
+        path.numGroupDelayLines = 0;
+    }
+    else
+    {
+        if (path.numGroupDelayLines != numChannelGroups)
+        {
+            path.groupDelayLines.reset(new CircularBuffer<Frame<4, SampleType>>[(size_t) numChannelGroups]);
+            path.numGroupDelayLines = numChannelGroups;
+        }
 
-    smoothedDelayTimeLeft.reset(currentSampleRate, 0.3f);
-    smoothedDelayTimeRight.reset(currentSampleRate, 0.3f);
-    smoothedChorusDepth.reset(currentSampleRate, 0.005);
-    smoothedChorusRate.reset(currentSampleRate, 0.005);
+        for (int group = 0; group < numChannelGroups; ++group)
+            path.groupDelayLines[(size_t) group].useStorage(arena.template getRegion<Frame<4, SampleType>>(firstDelayLineRegion + group),
+                                                            delayLineLength, mirrored, freshArena);
+    }
 
-    circBuffLeft.createCircularBuffer(2 * currentSampleRate);   // doubled or limited to 1365ms @ 48k
-    circBuffRight.createCircularBuffer(2 * currentSampleRate);
-    circBuffLeft.flushBuffer();
-    circBuffRight.flushBuffer();
+    return true;
 }
 
 
@@ -126,6 +305,7 @@ void ChorusAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    workerPool.stop();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -136,11 +316,17 @@ bool ChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
     return true;
   #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Mono, stereo, 5.1, 7.1 and 1st to 3rd-order ambisonics.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const auto& output = layouts.getMainOutputChannelSet();
+    const int ambisonicOrder = output.getAmbisonicOrder();
+
+    if (output != juce::AudioChannelSet::mono()
+     && output != juce::AudioChannelSet::stereo()
+     && output != juce::AudioChannelSet::create5point1()
+     && output != juce::AudioChannelSet::create7point1()
+     && (ambisonicOrder < 1 || ambisonicOrder > 3))
         return false;
 
     // This checks if the input layout matches the output layout
@@ -156,78 +342,459 @@ bool ChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 
 void ChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    process(buffer, midiMessages);
+}
+
+void ChorusAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, midiMessages);
+}
+
+bool ChorusAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void ChorusAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // the last prepare couldn't allocate the arena
+    if (bypassed)
+        return;
+
+    auto& path = getSignalPath<SampleType>();
+
+    // prepared for the other precision; hosts switch precision through prepareToPlay
+    if (path.filterChains.empty())
+    {
+        jassertfalse;
+        return;
+    }
 
     for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    const int numChannels = buffer.getNumChannels();
     const int numSamples = buffer.getNumSamples();
 
-    auto chainsettings = getChainSettings(apvts);
-    float dryWet = 1.f;
-    bool dualDelay = chainsettings.dualDelay;
+    // once the delay line has drained, silent input gives silent output: leave the buffer as it is and only
+    // keep the smoothers and LFOs in time, so processing picks up exactly where it would have been. This
+    // block's reads reach drainSamples before its start, so only the silent blocks before it count
+    const bool silent = isSilent(buffer);
+
+    if (! silent)
+        state->silentSamples = 0;
+
+    state->idle = silent && state->silentSamples >= drainSamples;
+
+    if (silent)
+        state->silentSamples = juce::jmin(drainSamples, state->silentSamples + numSamples);
+
+    // mono material on a stereo bus: once the delay line holds the same history in both lanes, one channel
+    // can be processed and copied; the right lane keeps being written, so it takes over without a seam.
+    // This block's reads reach drainSamples before its start, so only the identical blocks before it count
+    const bool identical = hasIdenticalChannels(buffer);
+
+    if (! identical)
+        state->identicalSamples = 0;
+
+    state->identicalChannels = identical && state->identicalSamples >= drainSamples;
+
+    if (identical)
+        state->identicalSamples = juce::jmin(drainSamples, state->identicalSamples + numSamples);
+
+    // changes the host timestamped for this block; everything else is picked up from the parameter atomics
+    const int numEvents = parameterEvents.collect(blockEvents.data(), (int) blockEvents.size(), numSamples);
+    ParameterSnapshot::DirtyMask deferred = 0;
+
+    for (int i = 0; i < numEvents; ++i)
+        deferred |= ParameterSnapshot::bit(blockEvents[(size_t) i].parameter);
+
+    // one load per parameter; derived state is only touched for the parameters that moved
+    auto dirty = parameters.update(deferred);
+
+    // with workers available, time serial and parallel blocks to see whether spreading the groups pays off
+    const bool timeBlock = workerPool.isRunning() && ! state->idle;
+    const auto startTicks = timeBlock ? juce::Time::getHighResolutionTicks() : 0;
+    state->runParallel = timeBlock && parallelism.shouldRunParallel();
+
+    // split the block at the event positions, each sub-block running the block kernel with its own settings
+    int eventIndex = 0;
+
+    for (int start = 0; start < numSamples;)
+    {
+        for (; eventIndex < numEvents && blockEvents[(size_t) eventIndex].sampleOffset <= start; ++eventIndex)
+            dirty |= parameters.apply(blockEvents[(size_t) eventIndex].parameter, blockEvents[(size_t) eventIndex].value);
+
+        const int end = eventIndex < numEvents ? blockEvents[(size_t) eventIndex].sampleOffset : numSamples;
+
+        processSubBlock(buffer, start, end - start, dirty);
+
+        dirty = 0;
+        start = end;
+    }
+
+    if (timeBlock)
+    {
+        parallelism.blockFinished(juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+
+        // serial is faster here: stop handing out work (a flag, nothing that blocks); the threads are joined
+        // on the message thread by the next prepareToPlay, which measures anew, or by releaseResources
+        if (parallelism.hasSettledOnSerial())
+            workerPool.retire();
+    }
+
+    if (state->idle)
+        return;
+
+    // the filters run in the same instruction-set variant as the kernels
+    dispatchInstructionSet(instructionSet, [&] (auto target)
+    {
+        decltype(target)::run([&]
+        {
+            juce::dsp::AudioBlock<SampleType> block(buffer);
+
+            for (int channel = 0; channel < juce::jmin((int) block.getNumChannels(), numPreparedChannels); ++channel)
+            {
+                auto channelBlock = block.getSingleChannelBlock((size_t) channel);
+                juce::dsp::ProcessContextReplacing<SampleType> context(channelBlock);
+                path.filterChains[(size_t) channel].process(context);
+            }
+        });
+    });
+}
+
+
+template <typename SampleType>
+void ChorusAudioProcessor::processSubBlock(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, ParameterSnapshot::DirtyMask dirty)
+{
+    const auto& chainsettings = parameters.getSettings();
     bool chorus = chainsettings.chorus;
-    float newChorusDepth = chainsettings.depth;
-    float newChorusRate = chainsettings.rate;
-    float newDelayTimeLeft = chainsettings.delayTimeLeft;
-    float newDelayTimeRight = dualDelay ? chainsettings.delayTimeRight : chainsettings.delayTimeLeft;
+    int voices = chainsettings.voices;
 
-    smoothedChorusDepth.setTargetValue(newChorusDepth);
-    chorusDepth = smoothedChorusDepth.getNextValue() + ((smoothedChorusDepth.getNextValue() - chorusDepth) * coeff_chrs); 
-    smoothedChorusRate.setTargetValue(newChorusRate);
-    chorusRate = smoothedChorusRate.getNextValue() + ((smoothedChorusRate.getNextValue() - chorusRate) * coeff_chrs); 
+    if (dirty & (ParameterSnapshot::bit(ParameterSnapshot::delayLeft) | ParameterSnapshot::bit(ParameterSnapshot::delayRight)
+                 | ParameterSnapshot::bit(ParameterSnapshot::dualDelay)))
+    {
+        state->smoothedDelayTimeLeft.setTargetValue(chainsettings.delayTimeLeft);
+        state->smoothedDelayTimeRight.setTargetValue(chainsettings.dualDelay ? chainsettings.delayTimeRight : chainsettings.delayTimeLeft);
+    }
 
-    for (int channel = 0; channel < numChannels; ++channel)
+    if (dirty & ParameterSnapshot::bit(ParameterSnapshot::depth))
+        state->smoothedChorusDepth.setTargetValue(chainsettings.depth);
+
+    if (dirty & ParameterSnapshot::bit(ParameterSnapshot::rate))
+        state->smoothedChorusRate.setTargetValue(chainsettings.rate);
+
+    // depth and rate hold for the sub-block, at the value their smoothers reach by its end
+    state->chorusDepth = state->smoothedChorusDepth.getValueAfter(numSamples);
+    state->chorusRate = state->smoothedChorusRate.getValueAfter(numSamples);
+    state->smoothedChorusDepth.skip(numSamples);
+    state->smoothedChorusRate.skip(numSamples);
+
+    const int numDelayChannels = juce::jmin(buffer.getNumChannels(), numPreparedChannels);
+
+    if (numDelayChannels == 0)
+        return;
+
+    const ChorusMode mode = ! chorus ? ChorusMode::off : (voices == 1 ? ChorusMode::single : ChorusMode::ensemble);
+
+    if (state->idle)
+    {
+        skipIdle<SampleType>(mode, numSamples);
+        return;
+    }
+
+    // every channel can share one delay curve when both are set to the same time and their smoothers agree
+    // (right after switching to a single delay the right-hand one is still gliding over). Ambisonic
+    // components always share it: a different delay or modulation per component would tear the soundfield
+    // apart on decoding rather than widen it, so Delay Left drives them all
+    const bool sharedDelay = ambisonicLayout
+                          || (! chainsettings.dualDelay && state->smoothedDelayTimeLeft.hasSameStateAs(state->smoothedDelayTimeRight));
+
+    // the right channel would come out identical to the left when it sees the same input, history, delay
+    // and read state
+    auto& path = getSignalPath<SampleType>();
+    const bool mirrorRight = state->identicalChannels && sharedDelay && numDelayChannels == 2 && path.delayLine.readStatesMatch(0, 1)
+                             && state->chorusLFO.lanesMatch(0, 1) && path.ensembles[0].hasSameStateAs(path.ensembles[1]);
+
+    // one switch per sub-block into the kernel specialised for this instruction set and combination of modes.
+    // The ensemble always runs the baseline: its per-voice tap reads gain nothing from the wider sets, and
+    // flattened into the voice loop they come out about twice as slow
+    dispatchInstructionSet(instructionSet, [&] (auto target)
     {
-    const float* inData = buffer.getReadPointer(channel);
-    float* outData = buffer.getWritePointer(channel);
+        using Target = decltype(target);
+
+        dispatchInterpolator(chainsettings.interpolation, [&] (auto policy)
+        {
+            using Interpolator = decltype(policy);
+
+            switch (mode)
+            {
+                case ChorusMode::off:       dispatchLayout<ChorusMode::off, Interpolator, Target>(sharedDelay, mirrorRight, numDelayChannels, buffer, startSample, numSamples); break;
+                case ChorusMode::single:    dispatchLayout<ChorusMode::single, Interpolator, Target>(sharedDelay, mirrorRight, numDelayChannels, buffer, startSample, numSamples); break;
+                case ChorusMode::ensemble:  dispatchLayout<ChorusMode::ensemble, Interpolator, InstructionSets::Baseline>(sharedDelay, mirrorRight, numDelayChannels, buffer, startSample, numSamples); break;
+                default:                    jassertfalse; break;
+            }
+        });
+    });
+}
+
+template <ChorusAudioProcessor::ChorusMode Mode, typename Interpolator, typename Target, typename SampleType>
+void ChorusAudioProcessor::dispatchLayout(bool sharedDelay, bool mirrorRight, int numChannels, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    // everything below is built for the target, inlined into this one call
+    Target::run([&]
+    {
+        if (numChannels == 1)
+            processKernel<Mode, false, 1, false, Interpolator, Target>(buffer, 1, startSample, numSamples);
+        else if (numChannels > 2)
+        {
+            if (sharedDelay)
+                processKernel<Mode, true, 4, false, Interpolator, Target>(buffer, numChannels, startSample, numSamples);
+            else
+                processKernel<Mode, false, 4, false, Interpolator, Target>(buffer, numChannels, startSample, numSamples);
+        }
+        else if (mirrorRight)
+            processKernel<Mode, false, 1, true, Interpolator, Target>(buffer, 1, startSample, numSamples);
+        else if (sharedDelay)
+            processKernel<Mode, true, 2, false, Interpolator, Target>(buffer, 2, startSample, numSamples);
+        else
+            processKernel<Mode, false, 2, false, Interpolator, Target>(buffer, 2, startSample, numSamples);
+    });
+}
+
+template <ChorusAudioProcessor::ChorusMode Mode, bool SharedDelay, int GroupSize, bool MirrorRight, typename Interpolator, typename Target, typename SampleType>
+void ChorusAudioProcessor::processKernel(juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples)
+{
+    // the single-voice LFO lanes modulate the delay times directly (multi-voice modes have their own)
+    constexpr bool modulated = Mode == ChorusMode::single;
+
+    // delay curves to compute: one per delay-time control (channels alternate left / right by index), or a
+    // shared one
+    constexpr int numDelayCurves = SharedDelay ? 1 : (GroupSize < 2 ? GroupSize : 2);
+
+    // delay line lanes written; a mirrored right channel still gets its history, ready to take over
+    constexpr int numWrittenLanes = MirrorRight ? 2 : GroupSize;
+
+    const int numGroups = (numChannels + GroupSize - 1) / GroupSize;
+    auto& path = getSignalPath<SampleType>();
+
+    // taken once here: the groups may be processed on other threads, which must not touch the buffer
+    // objects (getWritePointer() writes the buffer's isClear flag)
+    const SampleType* const* inputs = buffer.getArrayOfReadPointers();
+    SampleType* const* outputs = buffer.getArrayOfWritePointers();
+    SampleType* const* delayedRows = path.delayedSamples.getArrayOfWritePointers();
+
+    // the scratch buffers are sized in prepareToPlay, so walk the block in chunks of that size
+    jassert(maxScratchSamples > 0);
+    for (int offset = 0; offset < numSamples; offset += maxScratchSamples)
+    {
+        const int numChunkSamples = juce::jmin(maxScratchSamples, numSamples - offset);
+        const int start = startSample + offset;
+
+        if constexpr (modulated)
+            applyChorus();
+
+        float* delays[numDelayCurves];
+
+        for (int curve = 0; curve < numDelayCurves; ++curve)
+            delays[curve] = delayInSamples.getWritePointer(curve);
+
+        // chorus off and the smoothers settled: the delay is a constant, so skip the curves and read each
+        // channel as a block copy (or a fixed-fraction interpolation). It gives the same samples as the
+        // general path, so moving in and out of it is seamless
+        bool constantDelay = false;
+        float constantDelays[numDelayCurves] {};
+
+        if constexpr (Mode == ChorusMode::off)
+        {
+            constantDelay = ! state->smoothedDelayTimeLeft.isSmoothing() && (numDelayCurves == 1 || ! state->smoothedDelayTimeRight.isSmoothing());
+
+            if (constantDelay)
+                for (int curve = 0; curve < numDelayCurves; ++curve)
+                {
+                    const auto& smoothedDelayTime = curve == 0 ? state->smoothedDelayTimeLeft : state->smoothedDelayTimeRight;
+                    constantDelays[curve] = juce::jmax((float) Interpolator::newerTaps, smoothedDelayTime.getTargetValue() * state->samplesPerMs);
+                }
+        }
+
+        if (! constantDelay)
+        {
+            for (int curve = 0; curve < numDelayCurves; ++curve)
+            {
+                auto& smoothedDelayTime = curve == 0 ? state->smoothedDelayTimeLeft : state->smoothedDelayTimeRight;
+
+                if (! modulated && ! smoothedDelayTime.isSmoothing())
+                {
+                    // settled and unmodulated: a constant delay, nothing to evaluate
+                    juce::FloatVectorOperations::fill(delays[curve], smoothedDelayTime.getTargetValue() * state->samplesPerMs, numChunkSamples);
+                    continue;
+                }
+
+                // smoother, LFO and the ms -> samples mapping once every controlInterval samples, straight lines
+                // between; the sample where the ramp lands on its target is kept as a control point
+                const int rampEnd = smoothedDelayTime.getRemainingSteps() - 1;
+
+                ControlRate::render(delays[curve], numChunkSamples, controlInterval, [&] (int t)
+                {
+                    float delayTime = smoothedDelayTime.getValueAfter(t + 1);
+
+                    if constexpr (modulated)
+                        if (delayTime != 0.0f)
+                            delayTime += state->chorusLFO.getValue(curve, t);
+
+                    return delayTime * state->samplesPerMs;
+                }, rampEnd);
+            }
+
+            // every smoother moves on, including a right-hand one whose curve was shared
+            state->smoothedDelayTimeLeft.skip(numChunkSamples);
+
+            if constexpr (GroupSize > 1 || MirrorRight)
+                state->smoothedDelayTimeRight.skip(numChunkSamples);
 
-        for (int sample = 0; sample < numSamples; ++sample)
+            if constexpr (modulated)
+                state->chorusLFO.skip(numChunkSamples);
+
+            // taps newer than the read position must already be written (the delay ramps up from 0 at start)
+            if constexpr (Interpolator::newerTaps > 0)
+                for (int curve = 0; curve < numDelayCurves; ++curve)
+                    juce::FloatVectorOperations::max(delays[curve], delays[curve], (float) Interpolator::newerTaps, numChunkSamples);
+        }
+
+        // the curves are shared by every group; each group has its own delay line, channels, ensembles and
+        // scratch rows, so the groups can run side by side on the worker pool
+        auto processGroup = [&] (int group, int worker)
         {
+            auto& line = path.template getDelayLine<numWrittenLanes>(group);
+
+            const int firstChannel = group * GroupSize;
+            const int numLanes = juce::jmin(GroupSize, numChannels - firstChannel);
+            const int numLanesWritten = MirrorRight ? 2 : numLanes;
 
-            if (channel == 0) // left channel
+            const SampleType* laneInputs[numWrittenLanes] {};
+            const float* laneDelays[GroupSize] {};
+            float laneConstantDelays[GroupSize] {};
+            SampleType* delayed[GroupSize] {};
+
+            for (int lane = 0; lane < numLanesWritten; ++lane)
+                laneInputs[lane] = inputs[MirrorRight ? 0 : firstChannel + lane] + start;
+
+            for (int lane = 0; lane < numLanes; ++lane)
             {
-                smoothedDelayTimeLeft.setTargetValue(newDelayTimeLeft);
-                delayTimeLeft = smoothedDelayTimeLeft.getNextValue() + ((smoothedDelayTimeLeft.getNextValue() - delayTimeLeft) * coeff); //delayTimeLeft += (newDelayTimeLeft - delayTimeLeft) * coeff; // non-smoothed, apply one-pole filter
+                const int curve = SharedDelay ? 0 : lane % numDelayCurves;
 
-                if (chorus && (delayTimeLeft != 0.0f))
-                    applyChorus(sample, true);
+                laneDelays[lane] = delays[curve];
+                laneConstantDelays[lane] = constantDelays[curve];
+                delayed[lane] = delayedRows[worker * GroupSize + lane];
+            }
 
-                float delayedSample = circBuffLeft.readBuffer(delayTimeLeft * currentSampleRate / 1000.0);
-                circBuffLeft.writeBuffer(inData[sample] + 0 * delayedSample);
-                float wetScale = (1.0f - dryWet) + dryWet * 0.5;  // making this to control the volume changes when mixing dry/wet signals
-                outData[sample] = wetScale * inData[sample] + dryWet * delayedSample;  // dry / wet   //outData[sample] = delayedSample; // 100% wet  // outData[sample] = (1.0f - dryWet) * inData[sample] + dryWet * delayedSample; // original
-                writeIndexLeft = (writeIndexLeft + 1) % circBuffLeft.getBufferLength();
+            // every channel of the group goes into its interleaved delay line with a single write
+            line.writeChannels(laneInputs, numLanesWritten, numChunkSamples);
+
+            if (constantDelay)
+            {
+                line.template readLanesConstantDelay<Interpolator>(laneConstantDelays, delayed, numLanes, numChunkSamples);
             }
-            else if (channel == 1) // right channel
+            else if constexpr (Mode == ChorusMode::ensemble)
             {
-                smoothedDelayTimeRight.setTargetValue(newDelayTimeRight);
-                delayTimeRight = smoothedDelayTimeRight.getNextValue() + ((smoothedDelayTimeRight.getNextValue() - delayTimeRight) * coeff);
+                const int voices = parameters.getSettings().voices;
 
-                if (chorus && (delayTimeRight != 0.0f))
-                    applyChorus(sample, false);
+                for (int lane = 0; lane < numLanes; ++lane)
+                    path.ensembles[(size_t) (firstChannel + lane)].template process<Interpolator>(voices, line, lane, laneDelays[lane], delayed[lane],
+                                                                                               numChunkSamples, state->chorusRate, state->chorusDepth);
 
-                float delayedSample = circBuffRight.readBuffer(delayTimeRight * currentSampleRate / 1000.0);
-                circBuffRight.writeBuffer(inData[sample] + 0 * delayedSample);
-                float wetScale = (1.0f - dryWet) + dryWet * 0.5;
-                outData[sample] = wetScale * inData[sample] + dryWet * delayedSample; 
-                writeIndexRight = (writeIndexRight + 1) % circBuffRight.getBufferLength();
+                if constexpr (MirrorRight)
+                    path.ensembles[1].mirror(path.ensembles[0], voices, numChunkSamples, state->chorusRate, state->chorusDepth);
+            }
+            else if constexpr (SharedDelay || GroupSize == 1)
+            {
+                line.template readLanesSharedDelay<Interpolator>(delays[0], delayed, numLanes, numChunkSamples);
+            }
+            else
+            {
+                line.template readLanesFractional<Interpolator>(laneDelays, delayed, numLanes, numChunkSamples);
             }
+
+            if constexpr (MirrorRight)
+                line.mirrorReadState(0, 1);
+
+            mixDelayed(outputs, delayed, firstChannel, numLanes, MirrorRight, start, numChunkSamples);
+        };
+
+        if (GroupSize == 4 && state->runParallel)
+        {
+            // the pool calls in through a function pointer, which the flattening can't follow: enter the
+            // variant again on the worker's side
+            auto processGroupForTarget = [&] (int group, int worker) { Target::run([&] { processGroup(group, worker); }); };
+            workerPool.run(numGroups, processGroupForTarget);
         }
+        else
+            for (int group = 0; group < numGroups; ++group)
+                processGroup(group, 0);
     }
+}
 
-    juce::dsp::AudioBlock<float> block(buffer);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+template <typename SampleType>
+bool ChorusAudioProcessor::isSilent(const juce::AudioBuffer<SampleType>& buffer)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel), buffer.getNumSamples());
 
-    lastDelayTimeLeft = newDelayTimeLeft;
-    lastDelayTimeRight = newDelayTimeRight;
+        if (range.getStart() != SampleType() || range.getEnd() != SampleType())
+            return false;
+    }
+
+    return true;
 }
 
+template <typename SampleType>
+bool ChorusAudioProcessor::hasIdenticalChannels(const juce::AudioBuffer<SampleType>& buffer)
+{
+    return buffer.getNumChannels() == 2
+        && std::memcmp(buffer.getReadPointer(0), buffer.getReadPointer(1), (size_t) buffer.getNumSamples() * sizeof(SampleType)) == 0;
+}
+
+template <typename SampleType>
+void ChorusAudioProcessor::skipIdle(ChorusMode mode, int numSamples)
+{
+    // the same state the kernel would have moved on, so nothing jumps when the input comes back
+    state->smoothedDelayTimeLeft.skip(numSamples);
+    state->smoothedDelayTimeRight.skip(numSamples);
+
+    if (mode == ChorusMode::single)
+    {
+        applyChorus();
+        state->chorusLFO.skip(numSamples);
+    }
+    else if (mode == ChorusMode::ensemble)
+    {
+        const int voices = parameters.getSettings().voices;
+
+        for (auto& ensemble : getSignalPath<SampleType>().ensembles)
+            ensemble.skip(voices, numSamples, state->chorusRate, state->chorusDepth);
+    }
+}
+
+template <typename SampleType>
+void ChorusAudioProcessor::mixDelayed(SampleType* const* outputs, const SampleType* const* delayed, int firstChannel, int numChannels,
+                                      bool mirrorRight, int startSample, int numSamples)
+{
+    const SampleType dryWet = 1;
+    const SampleType wetScale = (1 - dryWet) + dryWet * (SampleType) 0.5;  // making this to control the volume changes when mixing dry/wet signals
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        SampleType* outData = outputs[firstChannel + channel] + startSample;
+
+        // dry / wet   //outData[sample] = delayedSample; // 100% wet  // outData[sample] = (1.0f - dryWet) * inData[sample] + dryWet * delayedSample; // original
+        juce::FloatVectorOperations::multiply(outData, wetScale, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(outData, delayed[channel], dryWet, numSamples);
+    }
+
+    if (mirrorRight)
+        juce::FloatVectorOperations::copy(outputs[1] + startSample, outputs[0] + startSample, numSamples);
+}
 
 //==============================================================================
 bool ChorusAudioProcessor::hasEditor() const
@@ -263,47 +830,31 @@ void ChorusAudioProcessor::setStateInformation (const void* data, int sizeInByte
     }
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {
-    ChainSettings settings;
-
-    settings.delayTimeLeft = apvts.getRawParameterValue("Delay Left")->load();
-    settings.delayTimeRight = apvts.getRawParameterValue("Delay Right")->load();
-    settings.depth = apvts.getRawParameterValue("Depth")->load();
-    settings.rate = apvts.getRawParameterValue("Rate")->load();
-    settings.dualDelay = apvts.getRawParameterValue("Dual Delay")->load() < 0.5f;
-    settings.chorus = apvts.getRawParameterValue("Chorus")->load() < 0.5f;
-
-    return settings;
+void ChorusAudioProcessor::applyChorus()
+{
+    // the increments only need recomputing when the smoothed rate / depth actually moved
+    if (state->chorusRate == state->appliedChorusRate && state->chorusDepth == state->appliedChorusDepth)
+        return;
+
+    // both lanes follow the shared Depth / Rate controls for now; per-channel controls only need to
+    // feed different values to setRate / setDepth for the right-hand lane
+    state->chorusLFO.setAll(state->chorusRate, state->chorusDepth);
+    state->appliedChorusRate = state->chorusRate;
+    state->appliedChorusDepth = state->chorusDepth;
 }
 
-void ChorusAudioProcessor::applyChorus(int sample, bool left)
+void ChorusAudioProcessor::setControlInterval(int interval)
 {
-    chorusModulation = chorusDepth * std::sin(2.0 * juce::MathConstants<float>::pi * chorusRate * sample / currentSampleRate + chorusPhase);
-
-    if (left) 
-    {
-        float newDelayTime = delayTimeLeft + chorusModulation;
-        delayTimeLeft = newDelayTime + (newDelayTime - delayTimeLeft) * coeff;
-    } 
-    else 
-    {
-        float newDelayTime = delayTimeRight + chorusModulation;
-        delayTimeRight = newDelayTime + (newDelayTime - delayTimeRight) * coeff;
-    }
+    jassert(ControlRate::isValidInterval(interval));
+    controlInterval = interval;
 
-    chorusPhase += 2.0 * juce::MathConstants<float>::pi * chorusRate / currentSampleRate;
+    for (auto& ensemble : floatPath.ensembles)
+        ensemble.setControlInterval(interval);
 
-    while (chorusPhase >= 2.0 * juce::MathConstants<float>::pi)
-        chorusPhase -= 2.0 * juce::MathConstants<float>::pi;
+    for (auto& ensemble : doublePath.ensembles)
+        ensemble.setControlInterval(interval);
 }
 
-// float ChorusAudioProcessor::smoothValues(float current, juce::LinearSmoothedValue<float> smoothed, float next)
-// { // need to fix this...
-//     smoothed.setTargetValue(next);
-//     current = smoothed.getNextValue() + ((smoothed.getNextValue() - current) * coeff); 
-//     return current;
-// }
-
 void ChorusAudioProcessor::updateFilters()
 {
     auto chainSettings = getChainSettings(apvts);
@@ -316,12 +867,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout ChorusAudioProcessor::create
 {
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
 
-    params.push_back(std::make_unique<juce::AudioParameterInt>("Delay Left", "Delay Left", 5, 40, 25));
-    params.push_back(std::make_unique<juce::AudioParameterInt>("Delay Right", "Delay Right", 5, 40, 15));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>("Depth", "Depth", juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f), 0.25f));
+    params.push_back(std::make_unique<juce::AudioParameterInt>("Delay Left", "Delay Left", 5, maxDelayTimeMs, 25));
+    params.push_back(std::make_unique<juce::AudioParameterInt>("Delay Right", "Delay Right", 5, maxDelayTimeMs, 15));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Depth", "Depth", juce::NormalisableRange<float>(0.f, maxDepthMs, 0.01f, 1.f), 0.25f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Rate", "Rate", juce::NormalisableRange<float>(1.f, 5.f, 0.02f, 1.f), 1.5f));
     params.push_back(std::make_unique<juce::AudioParameterBool>("Dual Delay", "Dual Delay", true));
     params.push_back(std::make_unique<juce::AudioParameterBool>("Chorus", "Chorus", false));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("Voices", "Voices", juce::StringArray { "1", "2", "4", "8" }, 0));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("Interpolation", "Interpolation", juce::StringArray { "None", "Linear", "Lagrange", "Hermite", "Allpass" }, 1));
 
     return { params.begin(), params.end() };
 }
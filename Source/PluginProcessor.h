@@ -9,130 +9,25 @@
 #pragma once
 
 #include <JuceHeader.h>
-
-inline double doLinearInterpolation(double y1, double y2, double fractional_X)
-{
-	// --- check invalid condition
-	if (fractional_X >= 1.0) return y2;
-
-	// --- use weighted sum method of interpolating
-	return fractional_X*y2 + (1.0 - fractional_X)*y1;
-}
-
-
-template <typename T>
-class CircularBuffer
-{
-public:
-	CircularBuffer() {}		/* C-TOR */
-	~CircularBuffer() {}	/* D-TOR */
-
-							/** flush buffer by resetting all values to 0.0 */
-	void flushBuffer(){ memset(&buffer[0], 0, bufferLength * sizeof(T)); }
-
-	/** Create a buffer based on a target maximum in SAMPLES
-	//	   do NOT call from realtime audio thread; do this prior to any processing */
-	void createCircularBuffer(unsigned int _bufferLength)
-	{
-		// --- find nearest power of 2 for buffer, and create
-		createCircularBufferPowerOfTwo((unsigned int)(pow(2, ceil(log(_bufferLength) / log(2)))));
-	}
-
-	/** Create a buffer based on a target maximum in SAMPLESwhere the size is
-	    pre-calculated as a power of two */
-	void createCircularBufferPowerOfTwo(unsigned int _bufferLengthPowerOfTwo)
-	{
-		// --- reset to top
-		writeIndex = 0;
-
-		// --- find nearest power of 2 for buffer, save it as bufferLength
-		bufferLength = _bufferLengthPowerOfTwo;
-
-		// --- save (bufferLength - 1) for use as wrapping mask
-		wrapMask = bufferLength - 1;
-
-		// --- create new buffer
-		buffer.reset(new T[bufferLength]);
-
-		// --- flush buffer
-		flushBuffer();
-	}
-
-	/** write a value into the buffer; this overwrites the previous oldest value in the buffer */
-	void writeBuffer(T input)
-	{
-		// --- write and increment index counter
-		buffer[writeIndex++] = input;
-
-		// --- wrap if index > bufferlength - 1
-		writeIndex &= wrapMask;
-	}
-
-	/** read an arbitrary location that is delayInSamples old */
-	T readBuffer(int delayInSamples)//, bool readBeforeWrite = true)
-	{
-		// --- subtract to make read index
-		//     note: -1 here is because we read-before-write,
-		//           so the *last* write location is what we use for the calculation
-		int readIndex = (writeIndex - 1) - delayInSamples;
-
-		// --- autowrap index
-		readIndex &= wrapMask;
-
-		// --- read it
-		return buffer[readIndex];
-	}
-
-	/** read an arbitrary location that includes a fractional sample */
-	T readBuffer(double delayInFractionalSamples)
-	{
-		// --- truncate delayInFractionalSamples and read the int part
-		T y1 = readBuffer((int)delayInFractionalSamples);
-
-		// --- if no interpolation, just return value
-		if (!interpolate) return y1;
-
-		// --- else do interpolation
-		//
-		// --- read the sample at n+1 (one sample OLDER)
-		T y2 = readBuffer((int)delayInFractionalSamples + 1);
-
-		// --- get fractional part
-		double fraction = delayInFractionalSamples - (int)delayInFractionalSamples;
-
-		// --- do the interpolation (you could try different types here)
-		return doLinearInterpolation(y1, y2, fraction);
-	}
-
-	/** enable or disable interpolation; usually used for diagnostics or in algorithms that require strict integer samples times */
-	void setInterpolate(bool b) { interpolate = b; }
-
-  unsigned int getBufferLength() { return bufferLength; }
-
-private:
-	std::unique_ptr<T[]> buffer = nullptr;	///< smart pointer will auto-delete
-	unsigned int writeIndex = 0;		///> write index
-	unsigned int bufferLength = 1024;	///< must be nearest power of 2
-	unsigned int wrapMask = bufferLength - 1;		///< must be (bufferLength - 1)
-	bool interpolate = true;			///< interpolation (default is ON)
-};
-
-struct ChainSettings {
-	float delayTimeLeft {0};
-	float delayTimeRight {0};
-	float depth {0};
-	float rate {0};
-	bool dualDelay {true};
-	bool chorus {false};
-};
-
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-
-using Filter = juce::dsp::IIR::Filter<float>;
-
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+#include "CircularBuffer.h"
+#include "LFO.h"
+#include "ChorusVoices.h"
+#include "Smoothers.h"
+#include "ControlRate.h"
+#include "ParameterSnapshot.h"
+#include "ParameterEvents.h"
+#include "WorkerPool.h"
+#include "InstructionSets.h"
+#include "DspArena.h"
+
+template <typename SampleType>
+using Filter = juce::dsp::IIR::Filter<SampleType>;
+
+template <typename SampleType>
+using CutFilter = juce::dsp::ProcessorChain<Filter<SampleType>, Filter<SampleType>, Filter<SampleType>, Filter<SampleType>>;
+
+template <typename SampleType>
+using MonoChain = juce::dsp::ProcessorChain<CutFilter<SampleType>, Filter<SampleType>, CutFilter<SampleType>>;
 
 //==============================================================================
 /**
@@ -156,6 +51,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -180,6 +77,38 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    /** timestamped parameter changes for the coming blocks, from whatever can see the host's sample
+        offsets; values posted here are applied at their offset instead of at the start of the block.
+        Nothing in the plugin posts here yet: see ParameterEventQueue */
+    ParameterEventQueue& getParameterEventQueue() { return parameterEvents; }
+
+    /** how often (in samples) the delay-time modulation is evaluated; 8, 16 or 32, or 1 for every sample.
+        do NOT call while processing */
+    void setControlInterval(int interval);
+
+    /** spread the channel groups of wide layouts (more than four channels) over worker threads when that
+        measures faster; on by default. Takes effect on the next prepareToPlay */
+    void setUseWorkerThreads(bool shouldUseWorkerThreads) { useWorkerThreads = shouldUseWorkerThreads; }
+
+    void audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup) override { hostWorkgroup = workgroup; }
+
+    /** run the kernels built for the given instruction set instead of the widest one the CPU has, e.g. to
+        test each variant; limited to what the CPU supports, std::nullopt goes back to choosing.
+        Takes effect on the next prepareToPlay */
+    void setInstructionSetOverride(std::optional<InstructionSet> set) { instructionSetOverride = set; }
+
+    /** the kernel variant in use, chosen in prepareToPlay */
+    InstructionSet getInstructionSet() const { return instructionSet; }
+
+    /** fault in and lock the arena (hot state, every per-block scratch buffer and the delay lines),
+        optionally on transparent huge pages, for render hosts under memory pressure; off by default. The
+        filter and voice objects themselves, a few KiB per channel, stay on the heap unlocked.
+        Takes effect on the next prepareToPlay */
+    void setLockAudioMemory(bool shouldLock, bool useHugePages = false) { arena.setOptions({ shouldLock, useHugePages }); }
+
+    /** bytes locked by the last prepareToPlay; less than the arena when RLIMIT_MEMLOCK is too low */
+    size_t getLockedAudioMemoryBytes() const { return arena.getNumLockedBytes(); }
+
     // custom layout
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
     juce::AudioProcessorValueTreeState apvts;
@@ -189,30 +118,163 @@ public:
 private:
 	ApplicationProperties appProperties;
 
+	/** the delay lines, voices, filters and delayed-signal scratch for one sample precision; the control side
+		(smoothers, LFOs, delay curves) is float and shared. prepareToPlay only allocates the precision the
+		host is using; the delay lines' memory and the scratch are in the arena */
+	template <typename SampleType>
+	struct SignalPath
+	{
+		CircularBuffer<Frame<2, SampleType>> delayLine;		// left and right side by side, one write index for both
+		CircularBuffer<SampleType> monoDelayLine;			// the mono bus layout's
+		std::unique_ptr<CircularBuffer<Frame<4, SampleType>>[]> groupDelayLines;	// more than two channels: four per line
+		int numGroupDelayLines = 0;
+		std::vector<ChorusEnsemble<SampleType>> ensembles;	// 2 / 4 / 8 voice modes, one per channel
+		std::vector<MonoChain<SampleType>> filterChains;	// one per channel
+		juce::AudioBuffer<SampleType> delayedSamples;		// per channel of the group being processed, one set per worker
+
+		/** a channel group's delay line: plain samples for mono, stereo frames, or one of the 4-lane groups */
+		template <int NumLanes>
+		auto& getDelayLine(int group)
+		{
+			if constexpr (NumLanes == 1)
+				return monoDelayLine;
+			else if constexpr (NumLanes == 2)
+				return delayLine;
+			else
+				return groupDelayLines[(size_t)group];
+		}
+
+		/** give the memory back, e.g. for the precision the host is not using */
+		void release()
+		{
+			monoDelayLine.releaseBuffer();
+			delayLine.releaseBuffer();
+			groupDelayLines.reset();
+			numGroupDelayLines = 0;
+			ensembles.clear();
+			filterChains.clear();
+			delayedSamples.setSize(0, 0);
+		}
+	};
+
+	template <typename SampleType>
+	SignalPath<SampleType>& getSignalPath()
+	{
+		if constexpr (std::is_same<SampleType, double>::value)
+			return doublePath;
+		else
+			return floatPath;
+	}
+
+	/** allocate path for the current layout and block size; false when its memory couldn't be allocated.
+		do NOT call from realtime audio thread */
+	template <typename SampleType>
+	bool prepareSignalPath(SignalPath<SampleType>& path, const juce::dsp::ProcessSpec& spec);
+
+	/** processBlock() for either precision */
+	template <typename SampleType>
+	void process(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+
 	void updateFilters();
-	void applyChorus(int sample, bool left);
-	float smoothValues(float current, juce::LinearSmoothedValue<float> smoothed, float next);
+	void applyChorus();
+
+	template <typename SampleType>
+	void processSubBlock(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, ParameterSnapshot::DirtyMask dirty);
+
+	enum class ChorusMode { off, single, ensemble };	// no modulation / LFO per channel / 2, 4 or 8 voices
+
+	template <ChorusMode Mode, typename Interpolator, typename Target, typename SampleType>
+	void dispatchLayout(bool sharedDelay, bool mirrorRight, int numChannels, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+
+	/** the block kernel with every mode decision made at compile time. Channels run GroupSize at a time,
+		one delay line of GroupSize-wide frames per group (1 for mono, 2 for stereo, 4 above that); with
+		MirrorRight only the left channel is processed and the right one (identical input, settings and
+		state) is a copy of it. Target is the instruction-set variant it runs in.
+
+		Without SharedDelay, even channels follow Delay Left and odd ones Delay Right: in JUCE's 5.1 order
+		that is L, C, Ls on the left and R, LFE, Rs on the right, and 7.1 adds Lrs left and Rrs right.
+		Ambisonic layouts always run SharedDelay */
+	template <ChorusMode Mode, bool SharedDelay, int GroupSize, bool MirrorRight, typename Interpolator, typename Target, typename SampleType>
+	void processKernel(juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples);
 
-	MonoChain leftChain, rightChain;
-	juce::LinearSmoothedValue<float> smoothedDelayTimeLeft, smoothedDelayTimeRight, smoothedChorusDepth, smoothedChorusRate;
+	/** true when every channel of the block is digital silence */
+	template <typename SampleType>
+	static bool isSilent(const juce::AudioBuffer<SampleType>& buffer);
 
-	CircularBuffer<float> circBuffLeft;
-	CircularBuffer<float> circBuffRight;
+	/** true for a stereo block whose channels are bit for bit the same */
+	template <typename SampleType>
+	static bool hasIdenticalChannels(const juce::AudioBuffer<SampleType>& buffer);
+
+	/** move the smoothers and LFOs on over a sub-block that is not processed */
+	template <typename SampleType>
+	void skipIdle(ChorusMode mode, int numSamples);
+
+	/** scale the dry signal of numChannels channels from firstChannel on and add the delayed one;
+		mirrorRight copies the mixed left channel to the right */
+	template <typename SampleType>
+	static void mixDelayed(SampleType* const* outputs, const SampleType* const* delayed, int firstChannel, int numChannels,
+						   bool mirrorRight, int startSample, int numSamples);
+
+	static constexpr int maxChannels = 16;			// up to 3rd-order ambisonics
+	static constexpr int maxDelayTimeMs = 40;		// Delay Left / Right upper bound
+	static constexpr float maxDepthMs = 1.0f;		// Depth upper bound; the LFOs swing the delay by up to this
+
+	ParameterSnapshot parameters { apvts };		// resolved once; read once per block
+	ParameterEventQueue parameterEvents;
+	std::array<ParameterEvent, ParameterEventQueue::capacity> blockEvents;	// this block's events, in time order
+
+	/** what the audio thread moves on every block, kept together at the front of the arena rather than
+		scattered between the processor's other members */
+	struct HotState
+	{
+		LinearSmoother smoothedDelayTimeLeft, smoothedDelayTimeRight;	// evaluated at control rate
+		OnePoleCascade<2> smoothedChorusDepth, smoothedChorusRate;		// leave the old value with zero slope
+		LFOBank<2> chorusLFO;	// one lane per delay curve (left / right)
+
+		float samplesPerMs = 44.1f;				// delay times in ms -> the delay curves in samples
+		float chorusRate = 0.f;
+		float chorusDepth = 0.f;
+		float appliedChorusRate = -1.f;		// what the LFO bank was last set to
+		float appliedChorusDepth = -1.f;
+
+		int silentSamples = 0;		// silent input so far, counted up to drainSamples
+		int identicalSamples = 0;	// left == right input so far, counted up to drainSamples
+		bool idle = false;			// drained and still silent: the block is skipped
+		bool identicalChannels = false;		// this block and the whole read window have left == right
+		bool runParallel = false;			// this block's channel groups go over the pool
+	};
+
+	/** lay the arena out for the current layout, block size and precision: the hot state, the per-block
+		scratch, then the delay lines. The memory is kept while it has room, and the hot state moves over
+		when it hasn't; false, with the old arena and hot state left as they were, when a new arena can't be
+		allocated. do NOT call from realtime audio thread */
+	template <typename SampleType>
+	bool prepareArena(SignalPath<SampleType>& path);
+
+	DspArena arena;						// hot state, scratch and delay lines; not the filter and voice objects
+	HotState* state = nullptr;			// at the front of the arena, from the first prepareToPlay on
+	bool bypassed = true;				// the last prepareToPlay couldn't allocate: blocks pass through untouched
+
+	SignalPath<float> floatPath;
+	SignalPath<double> doublePath;
+	int numChannelGroups = 0;
+	int numPreparedChannels = 2;			// from the bus layout at prepareToPlay; only its delay lines are allocated
+	bool ambisonicLayout = false;			// from the bus layout at prepareToPlay: one delay curve for every component
 	double currentSampleRate;
 
-	int writeIndexLeft = 0;
-	int writeIndexRight = 0;
-	float lastDelayTimeLeft = 100.0f;
-	float lastDelayTimeRight = 100.0f;
-	float coeff;
-	float coeff_chrs;
-	float delayTimeLeft;
-	float delayTimeRight;
-
-	float chorusRate; 
-	float chorusDepth;
-	float chorusPhase = 0.f;
-	float chorusModulation = 0.f;
+	juce::AudioBuffer<float> delayInSamples;	// per-block scratch, per delay curve, in the arena
+	int maxScratchSamples = 0;
+
+	int controlInterval = ControlRate::defaultInterval;	// samples between modulation evaluations
+	int drainSamples = 0;		// silent input needed before the delay line reads nothing but silence
+
+	WorkerPool workerPool;				// started in prepareToPlay for layouts with several channel groups
+	ParallelismProbe parallelism;
+	juce::AudioWorkgroup hostWorkgroup;	// the host's thread budget, and a group for the workers to join
+	bool useWorkerThreads = true;
+
+	InstructionSet instructionSet = InstructionSet::baseline;	// the kernel variant, picked in prepareToPlay
+	std::optional<InstructionSet> instructionSetOverride;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusAudioProcessor)
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    Parameter smoothers evaluated in closed form at any point of a block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Each smoother's value is a closed form in the block start state and the sample index, with no
+	dependency on the previous sample, so control-rate callers evaluate just the points they need with
+	getValueAfter() (without moving on) and then skip() the block; once settled that is the target and no
+	work. They share an interface: reset(), setCurrentAndTargetValue(), setTargetValue(), isSmoothing(),
+	getCurrentValue(), getTargetValue(), getValueAfter() and skip() */
+
+/** straight line to the target over a fixed number of samples */
+class LinearSmoother
+{
+public:
+	LinearSmoother() {}		/* C-TOR */
+	~LinearSmoother() {}	/* D-TOR */
+
+	/** set the ramp length; do NOT call from realtime audio thread. Snaps to the target */
+	void reset(double sampleRate, double rampLengthInSeconds)
+	{
+		stepsToTarget = juce::jmax(1, (int)std::floor(rampLengthInSeconds * sampleRate));
+		setCurrentAndTargetValue(target);
+	}
+
+	void setCurrentAndTargetValue(float newValue)
+	{
+		current = target = newValue;
+		countdown = 0;
+	}
+
+	/** start a new ramp from wherever the current one is, if the target changed */
+	void setTargetValue(float newTarget)
+	{
+		if (newTarget == target)
+			return;
+
+		target = newTarget;
+		countdown = stepsToTarget;
+		step = (target - current) / (float)countdown;
+	}
+
+	bool isSmoothing() const { return countdown > 0; }
+	int getRemainingSteps() const { return countdown; }
+
+	/** true when both would render exactly the same values from here on */
+	bool hasSameStateAs(const LinearSmoother& other) const
+	{
+		return current == other.current && target == other.target && countdown == other.countdown
+			&& (countdown == 0 || step == other.step);
+	}
+	float getCurrentValue() const { return current; }
+	float getTargetValue() const { return target; }
+
+	/** the value numSteps samples on: current + step * numSteps while ramping */
+	float getValueAfter(int numSteps) const
+	{
+		return numSteps >= countdown ? target : current + step * (float)numSteps;
+	}
+
+	void skip(int numSteps)
+	{
+		if (countdown == 0)
+			return;
+
+		const int rampSamples = juce::jmin(numSteps, countdown);
+		countdown -= rampSamples;
+		current = countdown == 0 ? target : current + step * (float)rampSamples;
+	}
+
+private:
+	float current = 0.0f;
+	float target = 0.0f;
+	float step = 0.0f;
+	int countdown = 0;				///< samples left in the ramp
+	int stepsToTarget = 1;
+};
+
+/** Order one-pole lowpasses in series, each with the same pole; Order 1 is the plain exponential, higher
+	orders start more smoothly (the output leaves the old value with zero slope). With d_j the distance of
+	stage j from the target at the block start and q = 1 - pole, stage k is n samples later at
+		target + pole^n * sum over j <= k of d_j * q^(k - j) * C(n + k - j - 1, k - j)
+	so the last stage is a short polynomial in n times pole^n */
+template <int Order>
+class OnePoleCascade
+{
+public:
+	static_assert(Order >= 1 && Order <= 4, "OnePoleCascade supports 1 to 4 stages");
+
+	OnePoleCascade() {}		/* C-TOR */
+	~OnePoleCascade() {}	/* D-TOR */
+
+	/** set the overall time constant, shared out across the stages; do NOT call from realtime audio thread */
+	void reset(double sampleRate, double timeConstantInSeconds)
+	{
+		const double stageTime = timeConstantInSeconds / (double)Order;
+		pole = std::exp(-1.0 / juce::jmax(1.0, stageTime * sampleRate));
+		setCurrentAndTargetValue(target);
+	}
+
+	void setCurrentAndTargetValue(float newValue)
+	{
+		target = newValue;
+		distance.fill(0.0);
+		smoothing = false;
+	}
+
+	void setTargetValue(float newTarget)
+	{
+		if (newTarget == target)
+			return;
+
+		for (auto& d : distance)
+			d += (double)target - (double)newTarget;
+
+		target = newTarget;
+		smoothing = true;
+	}
+
+	bool isSmoothing() const { return smoothing; }
+	float getCurrentValue() const { return (float)(target + distance[Order - 1]); }
+	float getTargetValue() const { return target; }
+
+	/** the value numSteps samples on */
+	float getValueAfter(int numSteps) const
+	{
+		return (float)(target + stageDistanceAfter(Order - 1, (double)numSteps));
+	}
+
+	/** move every stage on by numSteps using the same closed form */
+	void skip(int numSteps)
+	{
+		if (!smoothing)
+			return;
+
+		std::array<double, Order> next {};
+		bool settled = true;
+
+		for (int k = 0; k < Order; ++k)
+		{
+			next[(size_t)k] = stageDistanceAfter(k, (double)numSteps);
+			settled = settled && std::abs(next[(size_t)k]) < settledDistance;
+		}
+
+		distance = next;
+
+		if (settled)
+			setCurrentAndTargetValue(target);
+	}
+
+private:
+	static constexpr double settledDistance = 1.0e-6;
+
+	/** stage k's distance from the target n samples on: the sum above over the first k + 1 stages */
+	double stageDistanceAfter(int k, double n) const
+	{
+		const double q = 1.0 - pole;
+
+		double sum = distance[(size_t)k];
+		double binomial = 1.0;
+
+		for (int m = 1; m <= k; ++m)
+		{
+			binomial *= (n + (double)m - 1.0) / (double)m;
+			sum += distance[(size_t)(k - m)] * std::pow(q, (double)m) * binomial;
+		}
+
+		return std::pow(pole, n) * sum;
+	}
+
+	float target = 0.0f;
+	std::array<double, Order> distance {};		///< each stage's value - target, first stage first
+	double pole = 0.0;
+	bool smoothing = false;
+};
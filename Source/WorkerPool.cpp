@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    Pre-started worker threads for spreading independent tasks inside one
+    processBlock call.
+
+  ==============================================================================
+*/
+
+#include "WorkerPool.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <semaphore.h>
+#endif
+
+namespace
+{
+    /** tell the core we are busy-waiting, so the spin doesn't starve a sibling hyperthread */
+    inline void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (defined (__aarch64__) || defined (__arm__))
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+
+    inline juce::uint32 generationOf (juce::uint64 claim) noexcept { return (juce::uint32) (claim >> 32); }
+    inline int taskOf (juce::uint64 claim) noexcept                { return (int) (claim & 0xffffffffu); }
+
+    /** the OS's counting semaphore: post() takes no lock and only makes a system call when a thread is
+        waiting, so the audio thread can wake a worker without ever blocking on one */
+    class Semaphore
+    {
+    public:
+       #if JUCE_MAC || JUCE_IOS
+        Semaphore()   : semaphore (dispatch_semaphore_create (0)) {}
+        ~Semaphore()  { dispatch_release (semaphore); }
+        void post()   { dispatch_semaphore_signal (semaphore); }
+        void wait()   { dispatch_semaphore_wait (semaphore, DISPATCH_TIME_FOREVER); }
+       #elif JUCE_WINDOWS
+        Semaphore()   : semaphore (CreateSemaphoreW (nullptr, 0, 1, nullptr)) {}
+        ~Semaphore()  { CloseHandle (semaphore); }
+        void post()   { ReleaseSemaphore (semaphore, 1, nullptr); }
+        void wait()   { WaitForSingleObject (semaphore, INFINITE); }
+       #else
+        Semaphore()   { sem_init (&semaphore, 0, 0); }
+        ~Semaphore()  { sem_destroy (&semaphore); }
+        void post()   { sem_post (&semaphore); }
+        void wait()   { while (sem_wait (&semaphore) != 0) {} }     // EINTR: a signal, not a post
+       #endif
+
+    private:
+       #if JUCE_MAC || JUCE_IOS
+        dispatch_semaphore_t semaphore;
+       #elif JUCE_WINDOWS
+        HANDLE semaphore;
+       #else
+        sem_t semaphore;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (Semaphore)
+    };
+}
+
+//==============================================================================
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker (WorkerPool& owner, int index, const juce::AudioWorkgroup& hostWorkgroup, juce::uint32 startGeneration)
+        : juce::Thread ("Chorus worker " + juce::String (index)),
+          pool (owner), workerIndex (index), workgroup (hostWorkgroup), generation (startGeneration)
+    {
+    }
+
+    void run() override
+    {
+        // on hosts that group their audio threads, scheduling ours with them keeps them on the same deadline
+        juce::WorkgroupToken token;
+
+        if (workgroup)
+            workgroup.join (token);
+
+        while (pool.waitForWork (*this, generation))
+            pool.runTasks (generation, workerIndex);
+    }
+
+    /** from the worker itself, after checking there is nothing to do: announce it is about to sleep */
+    void announcePark()     { parked.store (true); }
+
+    /** from the worker, having found work after all; the sleep is off unless a wake is already on its way */
+    void cancelPark()
+    {
+        if (! parked.exchange (false))
+            wakeup.wait();      // posted, or about to be: take it so the count stays balanced
+    }
+
+    /** from the worker: sleep until wake() */
+    void park()             { wakeup.wait(); }
+
+    /** from anyone; a post only when the worker announced a park, and only one per park */
+    void wake()
+    {
+        if (parked.exchange (false))
+            wakeup.post();
+    }
+
+private:
+    WorkerPool& pool;
+    const int workerIndex;
+    const juce::AudioWorkgroup workgroup;
+    juce::uint32 generation;
+
+    std::atomic<bool> parked { false };
+    Semaphore wakeup;
+};
+
+//==============================================================================
+WorkerPool::WorkerPool() {}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start (int newNumWorkers, const juce::AudioWorkgroup& workgroup)
+{
+    newNumWorkers = juce::jlimit (0, maxWorkers, newNumWorkers);
+
+    // hosts prepare again on every transport start: keep realtime threads that are already what we need
+    if (isRunning() && newNumWorkers == numWorkers && workgroup == workerWorkgroup)
+        return;
+
+    stop();
+
+    stopping.store (false);
+    numWorkers = newNumWorkers;
+    workerWorkgroup = workgroup;
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers[i] = std::make_unique<Worker> (*this, i + 1, workgroup, currentGeneration);
+
+        if (! workers[i]->startRealtimeThread ({}))
+            workers[i]->startThread (juce::Thread::Priority::highest);
+    }
+}
+
+void WorkerPool::stop()
+{
+    if (numWorkers == 0)
+        return;
+
+    stopping.store (true);
+    wakeParked();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers[i]->stopThread (1000);
+        workers[i].reset();
+    }
+
+    numWorkers = 0;
+    workerWorkgroup = {};
+}
+
+void WorkerPool::retire()
+{
+    // parked workers stay asleep until stop() on the message thread; nothing to wake from here
+    stopping.store (true);
+}
+
+void WorkerPool::wakeParked()
+{
+    for (int i = 0; i < numWorkers; ++i)
+        workers[i]->wake();
+}
+
+bool WorkerPool::hasNews (juce::uint32 generation) const
+{
+    return stopping.load() || generationOf (nextTask.load()) != generation;
+}
+
+void WorkerPool::run (int tasks, TaskFunction function, void* context)
+{
+    if (tasks <= 0)
+        return;
+
+    if (! isRunning() || tasks == 1)
+    {
+        for (int task = 0; task < tasks; ++task)
+            function (context, task, 0);
+
+        return;
+    }
+
+    taskFunction.store (function);
+    taskContext.store (context);
+    numTasks.store (tasks);
+    tasksDone.store (0);
+
+    // publishing the new generation releases the job above to every worker
+    ++currentGeneration;
+    nextTask.store ((juce::uint64) currentGeneration << 32);
+
+    // spinning workers see the new generation by themselves
+    wakeParked();
+
+    runTasks (currentGeneration, 0);
+
+    // every task is claimed; anything not done yet is already running on a worker
+    while (tasksDone.load() < tasks)
+        spinPause();
+}
+
+void WorkerPool::runTasks (juce::uint32 generation, int worker)
+{
+    for (;;)
+    {
+        auto claim = nextTask.load();
+        int task = 0;
+
+        for (;;)
+        {
+            // a newer run has started (so this one is finished), or nothing left to claim
+            if (generationOf (claim) != generation)
+                return;
+
+            task = taskOf (claim);
+
+            if (task >= numTasks.load())
+                return;
+
+            if (nextTask.compare_exchange_weak (claim, claim + 1))
+                break;
+        }
+
+        // the claim succeeded, so the run is still in progress and the job fields are still its own
+        taskFunction.load() (taskContext.load(), task, worker);
+        tasksDone.fetch_add (1);
+    }
+}
+
+bool WorkerPool::waitForWork (Worker& worker, juce::uint32& generation)
+{
+    for (int spin = 0;; ++spin)
+    {
+        if (stopping.load())
+            return false;
+
+        const auto latest = generationOf (nextTask.load());
+
+        if (latest != generation)
+        {
+            generation = latest;
+            return true;
+        }
+
+        if (spin < spinIterations)
+        {
+            spinPause();
+            continue;
+        }
+
+        // parked until run() or stop() wakes us; no timeout, so an unused pool doesn't wake at all. The park
+        // is announced before looking again, so a run published meanwhile is either seen here or wakes us
+        worker.announcePark();
+
+        if (hasNews (generation))
+            worker.cancelPark();
+        else
+            worker.park();
+
+        spin = 0;
+    }
+}
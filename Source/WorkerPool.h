@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    Pre-started worker threads for spreading independent tasks inside one
+    processBlock call.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** A fixed set of threads started ahead of time (prepareToPlay), so the audio thread can hand out tasks with
+	no allocation, no locks and no thread creation. run() bumps a generation counter and workers spinning on
+	it pick the tasks up straight away; a worker that has parked (on its own semaphore, with no timeout, so
+	an idle pool costs nothing) is woken with one atomic exchange and a semaphore post, which only enters
+	the kernel because someone is waiting. The calling thread always works through the tasks too and only
+	ever waits for tasks already running, so a worker that is parked or slow to wake costs its share of the
+	work, never a deadline */
+class WorkerPool
+{
+public:
+	using TaskFunction = void (*)(void* context, int task, int worker);
+
+	static constexpr int maxWorkers = 15;
+
+	WorkerPool();		/* C-TOR */
+	~WorkerPool();		/* D-TOR */
+
+	/** start numWorkers threads (none for 0), joining the host's audio workgroup where there is one; threads
+	//	   already running for the same count and workgroup are kept. do NOT call from realtime audio thread */
+	void start(int numWorkers, const juce::AudioWorkgroup& workgroup);
+
+	/** stop and join every thread; do NOT call from realtime audio thread */
+	void stop();
+
+	/** stop handing out tasks, e.g. once the work has turned out faster without them; from then on run()
+	//	   does every task on the calling thread. Only sets a flag: workers still spinning see it and finish,
+	//	   parked ones are woken and joined by the next start() or stop(). Realtime-safe */
+	void retire();
+
+	int getNumWorkers() const { return numWorkers; }
+
+	/** true while there are threads taking tasks, i.e. started and not retired */
+	bool isRunning() const { return numWorkers > 0 && ! stopping.load(); }
+
+	/** call function(context, task, worker) for every task in [0, numTasks) and return when all are done;
+	//	   worker is 0 for the calling thread and 1 to getNumWorkers() for the pool. Realtime-safe */
+	void run(int numTasks, TaskFunction function, void* context);
+
+	/** the same for a callable taking (int task, int worker) */
+	template <typename Function>
+	void run(int numTasks, Function& function)
+	{
+		run(numTasks, [] (void* context, int task, int worker) { (*static_cast<Function*>(context))(task, worker); }, &function);
+	}
+
+private:
+	class Worker;
+
+	/** claim and run tasks of the given generation until none are left */
+	void runTasks(juce::uint32 generation, int worker);
+
+	/** spin until the generation moves on from the given one, then park; false when stopping */
+	bool waitForWork(Worker& worker, juce::uint32& generation);
+
+	/** true when there is something for a worker last busy with the given generation: a new run, or stopping */
+	bool hasNews(juce::uint32 generation) const;
+
+	/** wake the parked workers to look at the generation and stopping flag again; lock-free */
+	void wakeParked();
+
+	static constexpr int spinIterations = 4000;
+
+	// --- (generation << 32) | next task index; one word, so a claim can't mix up two runs
+	std::atomic<juce::uint64> nextTask { 0 };
+	std::atomic<int> tasksDone { 0 };
+	std::atomic<bool> stopping { false };
+
+	// --- written by run() before the generation is published, read by whoever claims a task
+	std::atomic<TaskFunction> taskFunction { nullptr };
+	std::atomic<void*> taskContext { nullptr };
+	std::atomic<int> numTasks { 0 };
+	juce::uint32 currentGeneration = 0;		///< only touched by run()
+
+	std::unique_ptr<Worker> workers[maxWorkers];
+	int numWorkers = 0;
+	juce::AudioWorkgroup workerWorkgroup;	///< the one the threads joined
+
+	JUCE_DECLARE_NON_COPYABLE(WorkerPool)
+};
+
+/** decides from measured block times whether spreading the work over a WorkerPool pays off: a few blocks
+	are timed serially and then in parallel, and the faster one is used; parallel until the next check,
+	serial until the next reset() */
+class ParallelismProbe
+{
+public:
+	/** start over, e.g. after prepareToPlay */
+	void reset()
+	{
+		blocksInPhase = 0;
+		phase = Phase::timingSerial;
+		serialTicks = parallelTicks = 0;
+		serialSamples = parallelSamples = 0;
+	}
+
+	/** whether the coming block should run in parallel */
+	bool shouldRunParallel() const
+	{
+		return phase == Phase::timingParallel || (phase == Phase::decided && parallelWins);
+	}
+
+	/** true once the trial has found serial faster; nothing is measured again until reset() */
+	bool hasSettledOnSerial() const { return phase == Phase::decided && ! parallelWins; }
+
+	/** report how long the block took; not needed (nor counted) once settled on serial */
+	void blockFinished(juce::int64 ticks, int numSamples)
+	{
+		++blocksInPhase;
+
+		switch (phase)
+		{
+			case Phase::timingSerial:
+				serialTicks += ticks;
+				serialSamples += numSamples;
+
+				if (blocksInPhase == trialBlocks)
+					nextPhase(Phase::timingParallel);
+				break;
+
+			case Phase::timingParallel:
+				parallelTicks += ticks;
+				parallelSamples += numSamples;
+
+				if (blocksInPhase == trialBlocks)
+				{
+					// --- per sample, and parallel has to win clearly to be worth the extra cores
+					parallelWins = (double)parallelTicks * minimumSpeedup * (double)serialSamples
+								 < (double)serialTicks * (double)parallelSamples;
+					nextPhase(Phase::decided);
+				}
+				break;
+
+			case Phase::decided:
+				// --- only parallel is re-checked: after a serial verdict the caller retires its workers
+				if (parallelWins && blocksInPhase == recheckBlocks)
+					reset();
+				break;
+
+			default:
+				jassertfalse;
+				break;
+		}
+	}
+
+private:
+	enum class Phase { timingSerial, timingParallel, decided };
+
+	static constexpr int trialBlocks = 32;
+	static constexpr int recheckBlocks = 8192;		///< re-measure now and then; the load on the machine changes
+	static constexpr double minimumSpeedup = 1.2;
+
+	void nextPhase(Phase newPhase)
+	{
+		phase = newPhase;
+		blocksInPhase = 0;
+	}
+
+	Phase phase = Phase::timingSerial;
+	int blocksInPhase = 0;
+	juce::int64 serialTicks = 0, parallelTicks = 0;
+	juce::int64 serialSamples = 0, parallelSamples = 0;
+	bool parallelWins = false;
+};
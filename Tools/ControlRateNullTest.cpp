@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    Null test of control-rate modulation: the processor at each control
+    interval against the same processor evaluating every sample.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numBlocks = 200;
+
+    // the residual every interval has to stay under, relative to the output
+    constexpr double maxResidualDb = -80.0;
+
+    /** the processor's stereo output, block by block, for five sines from 110 Hz to 8 kHz through the
+        chorus at full depth */
+    std::vector<float> render (int controlInterval, int voicesIndex)
+    {
+        ChorusAudioProcessor processor;
+        processor.apvts.getParameter ("Depth")->setValueNotifyingHost (1.0f);
+
+        auto* voices = processor.apvts.getParameter ("Voices");
+        voices->setValueNotifyingHost (voices->convertTo0to1 ((float) voicesIndex));
+
+        processor.setControlInterval (controlInterval);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+        std::vector<float> output;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const auto time = (double) (block * blockSize + i) / sampleRate;
+                float sample = 0.0f;
+
+                for (auto frequency : { 110.0, 440.0, 1250.0, 3300.0, 8000.0 })
+                    sample += (float) (0.18 * std::sin (juce::MathConstants<double>::twoPi * frequency * time));
+
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                    buffer.getWritePointer (channel)[i] = sample;
+            }
+
+            processor.processBlock (buffer, midi);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                output.insert (output.end(), buffer.getReadPointer (channel), buffer.getReadPointer (channel) + blockSize);
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    /** energy of the difference relative to the energy of the reference */
+    double getResidualDb (const std::vector<float>& output, const std::vector<float>& reference)
+    {
+        double residual = 0.0, signal = 0.0;
+
+        for (size_t i = 0; i < reference.size(); ++i)
+        {
+            residual += juce::square ((double) output[i] - (double) reference[i]);
+            signal += juce::square ((double) reference[i]);
+        }
+
+        return juce::Decibels::gainToDecibels (std::sqrt (residual / signal), -200.0);
+    }
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    bool passed = true;
+
+    // 1 and 2 voices (choice indices 0 and 1)
+    for (int voicesIndex = 0; voicesIndex < 2; ++voicesIndex)
+    {
+        const auto reference = render (1, voicesIndex);
+
+        for (int interval : { 8, 16, 32 })
+        {
+            const auto residualDb = getResidualDb (render (interval, voicesIndex), reference);
+            passed = passed && residualDb < maxResidualDb;
+
+            std::printf ("%d voice(s), interval %2d: residual %6.1f dB\n", 1 << voicesIndex, interval, residualDb);
+        }
+    }
+
+    if (! passed)
+    {
+        std::printf ("FAILED: residual above %.0f dB\n", maxResidualDb);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    Times the delay line's per-sample read / write against its block calls.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/CircularBuffer.h"
+#include "../Source/DspArena.h"
+
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numBlocks = 20000;
+    constexpr int numRuns = 7;
+
+    volatile float sink = 0.0f;        // keeps the reads from being optimised away
+
+    /** best of numRuns, in ns per sample, of processBlock (input, delays, output) over numBlocks blocks.
+        The delay curve (10 +/- 5 ms swept by a 1 Hz sine) is worked out between the calls, so every path
+        reads the same delays and only the delay line itself is timed */
+    template <typename ProcessBlock>
+    double timeBestRun (ProcessBlock&& processBlock)
+    {
+        std::vector<float> input ((size_t) blockSize), delays ((size_t) blockSize), output ((size_t) blockSize);
+        juce::Random random (1);
+
+        for (auto& sample : input)
+            sample = random.nextFloat() * 2.0f - 1.0f;
+
+        double best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < numRuns; ++run)
+        {
+            double phase = 0.0, nanoseconds = 0.0;
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                for (auto& delay : delays)
+                {
+                    delay = (float) ((10.0 + 5.0 * std::sin (phase)) * sampleRate / 1000.0);
+                    phase += juce::MathConstants<double>::twoPi / sampleRate;
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                processBlock (input.data(), delays.data(), output.data());
+                nanoseconds += std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - start).count();
+
+                sink = output[0];
+            }
+
+            best = juce::jmin (best, nanoseconds / ((double) blockSize * numBlocks));
+        }
+
+        return best;
+    }
+}
+
+int main()
+{
+    // a two-second line, as the plugin sized them before the arena
+    const auto length = (unsigned int) juce::nextPowerOfTwo ((int) (2 * sampleRate));
+    const auto guardSamples = CircularBuffer<float>::getGuardSamples (length);
+
+    juce::HeapBlock<float> heapStorage (length + guardSamples, true);
+    CircularBuffer<float> delayLine;
+    delayLine.useStorage (heapStorage.get(), length, false, true);
+
+    auto perSample = [&delayLine] (const float* input, const float* delays, float* output)
+    {
+        for (int i = 0; i < blockSize; ++i)
+        {
+            output[i] = delayLine.readBuffer ((double) delays[i]);
+            delayLine.writeBuffer (input[i]);
+        }
+    };
+
+    auto perBlock = [&delayLine] (const float* input, const float* delays, float* output)
+    {
+        delayLine.writeBlock (input, blockSize);
+        delayLine.readBlockFractional (delays, output, blockSize);
+    };
+
+    const auto perSampleTime = timeBestRun (perSample);
+    const auto perBlockTime = timeBestRun (perBlock);
+
+    // the same block calls on the memory the plugin runs them on
+    DspArena arena;
+    arena.allocate ({ { length * sizeof (float), guardSamples * sizeof (float), true } });
+    delayLine.useStorage (arena.getRegion<float> (0), length, arena.isMirrored(), true);
+
+    const auto arenaTime = timeBestRun (perBlock);
+
+    auto report = [perSampleTime] (const char* path, double time)
+    {
+        std::printf ("  %-52s %6.2f ns/sample (%.2fx)\n", path, time, perSampleTime / time);
+    };
+
+    std::printf ("%d-sample blocks, best of %d runs of %d blocks\n", blockSize, numRuns, numBlocks);
+    report ("readBuffer (double) + writeBuffer", perSampleTime);
+    report ("writeBlock + readBlockFractional, heap", perBlockTime);
+    report (arena.isMirrored() ? "writeBlock + readBlockFractional, arena (mirrored)"
+                               : "writeBlock + readBlockFractional, arena", arenaTime);
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    Posts timestamped parameter changes to the processor's event queue and
+    checks them against the host splitting the block at the same samples.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numBlocks = 60;
+    constexpr int changeBlock = 20;     // the block the changes land in
+
+    // how far the event path may land from the host-split block. Both run the same sub-blocks through the
+    // same kernel, so they should match exactly; the margin only allows for rounding
+    constexpr float tolerance = 1.0e-5f;
+
+    /** how the changes in changeBlock reach the processor */
+    enum class Delivery
+    {
+        events,         ///< posted to the event queue, the block processed whole
+        splitBlock,     ///< the host processes the block in pieces, setting each parameter before its piece
+        blockStart      ///< set before the block, as JUCE's wrappers do
+    };
+
+    void setParameter (ChorusAudioProcessor& processor, const ParameterEvent& change)
+    {
+        auto* parameter = processor.apvts.getParameter (ParameterSnapshot::parameterIDs[change.parameter]);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (change.value));
+    }
+
+    void processRange (ChorusAudioProcessor& processor, juce::AudioBuffer<float>& buffer, int startSample, int endSample)
+    {
+        if (endSample <= startSample)
+            return;
+
+        juce::AudioBuffer<float> range (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, endSample - startSample);
+        juce::MidiBuffer midi;
+        processor.processBlock (range, midi);
+    }
+
+    /** the processor's stereo output for noise, different in each channel, with changes (in time order)
+        delivered in changeBlock */
+    std::vector<float> render (const std::vector<ParameterEvent>& changes, Delivery delivery)
+    {
+        ChorusAudioProcessor processor;
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::Random random (1);
+        std::vector<float> output;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.getWritePointer (channel)[i] = random.nextFloat() - 0.5f;
+
+            int start = 0;
+
+            if (block == changeBlock)
+            {
+                for (const auto& change : changes)
+                {
+                    if (delivery == Delivery::splitBlock)
+                    {
+                        processRange (processor, buffer, start, change.sampleOffset);
+                        start = change.sampleOffset;
+                    }
+
+                    setParameter (processor, change);
+
+                    if (delivery == Delivery::events)
+                        processor.getParameterEventQueue().push (change);
+                }
+            }
+
+            processRange (processor, buffer, start, blockSize);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                output.insert (output.end(), buffer.getReadPointer (channel), buffer.getReadPointer (channel) + blockSize);
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    float getMaxDifference (const std::vector<float>& a, const std::vector<float>& b)
+    {
+        float difference = 0.0f;
+
+        for (size_t i = 0; i < a.size(); ++i)
+            difference = juce::jmax (difference, std::abs (a[i] - b[i]));
+
+        return difference;
+    }
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    struct Case
+    {
+        const char* name;
+        std::vector<ParameterEvent> changes;
+    };
+
+    const std::vector<Case> cases
+    {
+        { "Delay Left 25 -> 10 ms at 64",       { { 64, ParameterSnapshot::delayLeft, 10.0f } } },
+        { "Delay Left 25 -> 10 ms at 300",      { { 300, ParameterSnapshot::delayLeft, 10.0f } } },
+        { "Delay Left 25 -> 10 ms at 511",      { { 511, ParameterSnapshot::delayLeft, 10.0f } } },
+        { "Depth 0.25 -> 0.8 ms at 200",        { { 200, ParameterSnapshot::depth, 0.8f } } },
+        { "Delay Right at 100, Rate at 400",    { { 100, ParameterSnapshot::delayRight, 30.0f },
+                                                  { 400, ParameterSnapshot::rate, 4.0f } } },
+        { "Voices 1 -> 4 at 256",               { { 256, ParameterSnapshot::voices, 2.0f } } }
+    };
+
+    bool passed = true;
+
+    for (const auto& test : cases)
+    {
+        const auto split = render (test.changes, Delivery::splitBlock);
+        const auto eventError = getMaxDifference (render (test.changes, Delivery::events), split);
+        const auto blockStartError = getMaxDifference (render (test.changes, Delivery::blockStart), split);
+
+        // the block-start figure shows the change is audible at all, so the event check means something
+        const bool casePassed = eventError <= tolerance && blockStartError > tolerance;
+        passed = passed && casePassed;
+
+        std::printf ("%-34s events %.2e, at block start %.2e  %s\n", test.name, (double) eventError, (double) blockStartError,
+                     casePassed ? "ok" : "FAILED");
+    }
+
+    return passed ? 0 : 1;
+}